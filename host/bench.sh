@@ -0,0 +1,104 @@
+#! /bin/sh
+# Pulse Generator timing regression benchmark
+#   Copyright (C) 2003 Free Software Foundation, Inc.
+#
+# This file is free software; you can redistribute it and/or modify it
+# under the terms of the GNU General Public License as published by the
+# Free Software Foundation; either version 2, or (at your option) any
+# later version.
+#
+# This file is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; see the file COPYING.  If not, write to
+# the Free Software Foundation, 59 Temple Place - Suite 330,
+# Boston, MA 02111-1307, USA.
+#
+# Usage: bench.sh [-u] [edges]
+#
+# Builds pulsesim for each configuration below (options separated by
+# commas), runs `edges' edges
+# (200000 by default) of each through the HC11 model and writes the
+# results as CSV on the standard output (see the -c option of
+# pulsesim.c).  They are then compared with bench.ref: the benchmark
+# fails when a metric got worse (the edge rate of the host excepted),
+# which is the case as soon as one edge moves.  With -u bench.ref is
+# replaced by the new results; do it when a change is meant to move
+# the numbers, and commit it with that change.
+
+HOST_CC=${HOST_CC-cc}
+HOST_CFLAGS=${HOST_CFLAGS--O2 -Wall}
+
+update=no
+if test "x$1" = x-u; then
+  update=yes
+  shift
+fi
+edges=${1-200000}
+
+configs="
+default:
+burst:-DPULSE_BURST,-DPULSE_PATTERN
+multi:-DPULSE_MULTI
+fast:-DPULSE_FAST
+rle:-DPULSE_RLE
+extended:-DPULSE_EXTENDED
+prescaler4:-DPULSE_PRESCALER=4
+wai:-DPULSE_WAI
+sweep:-DPULSE_SWEEP
+dds:-DPULSE_DDS
+random:-DPULSE_RANDOM
+"
+
+tmp=${TMPDIR-/tmp}/pulsebench.$$
+mkdir "$tmp" || exit 2
+trap 'rm -rf "$tmp"' 0 1 2 15
+
+# The PULSE_PATTERN table: runs of intervals below the single interval
+# floor and below the whole interrupt, which only the burst loop of
+# the handler can produce.
+{
+  echo "   1000,"
+  i=0; while test $i -lt 30; do echo "   120,"; i=`expr $i + 1`; done
+  echo "   2000,"
+  i=0; while test $i -lt 10; do echo "   80,"; i=`expr $i + 1`; done
+} > "$tmp/pattern.h"
+
+echo "config,metric,entry,value" > "$tmp/bench.csv"
+for c in $configs; do
+  name=${c%%:*}
+  flags=`echo "${c#*:}" | tr , ' '`
+  $HOST_CC $HOST_CFLAGS -I. -Igel -I"$tmp" $flags -o "$tmp/pulsesim" \
+    pulsesim.c hc11sim.c || exit 2
+  # A late edge makes pulsesim fail; it is judged against bench.ref.
+  "$tmp/pulsesim" -n "$edges" -c "$name" >> "$tmp/bench.csv"
+done
+cat "$tmp/bench.csv"
+
+if test $update = yes; then
+  cp "$tmp/bench.csv" bench.ref
+  exit 0
+fi
+
+awk -F, '
+  NR == FNR { if (FNR > 1) ref[$1 "," $2 "," $3] = $4; next }
+  FNR == 1 { next }
+  { seen[$1 "," $2 "," $3] = 1 }
+  $2 != "edges_per_s" && ($1 "," $2 "," $3) in ref \
+    && $4 + 0 > ref[$1 "," $2 "," $3] + 0 {
+      printf "regression: %s %s %s: %s, was %s\n", $1, $2, $3, $4,
+             ref[$1 "," $2 "," $3] > "/dev/stderr"
+      bad = 1
+    }
+  END {
+    for (k in ref)
+      if (!(k in seen))
+        {
+          printf "regression: %s missing\n", k > "/dev/stderr"
+          bad = 1
+        }
+    exit bad
+  }' bench.ref "$tmp/bench.csv"
@@ -0,0 +1,81 @@
+/* Host model of the GEL <sys/interrupts.h>
+   Copyright (C) 2003 Free Software Foundation, Inc.
+
+This file is free software; you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the
+Free Software Foundation; either version 2, or (at your option) any
+later version.
+
+In addition to the permissions in the GNU General Public License, the
+Free Software Foundation gives you unlimited permission to link the
+compiled version of this file with other programs, and to distribute
+those programs without any restriction coming from the use of this
+file.  (The General Public License restrictions do apply in other
+respects; for example, they cover modification of the file, and
+distribution when not linked into another program.)
+
+This file is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to
+the Free Software Foundation, 59 Temple Place - Suite 330,
+Boston, MA 02111-1307, USA.  */
+
+#ifndef _HOST_SYS_INTERRUPTS_H
+#define _HOST_SYS_INTERRUPTS_H
+
+/* The handlers are ordinary functions on the host; the model calls
+   them after charging the interrupt entry cycles.  */
+#define interrupt
+
+typedef void (* interrupt_t) (void);
+
+enum interrupt_vector
+{
+  RES0_VECTOR,
+  RES1_VECTOR,
+  RES2_VECTOR,
+  RES3_VECTOR,
+  RES4_VECTOR,
+  RES5_VECTOR,
+  RES6_VECTOR,
+  RES7_VECTOR,
+  RES8_VECTOR,
+  RES9_VECTOR,
+  RES10_VECTOR,
+  SCI_VECTOR,
+  SPI_VECTOR,
+  ACC_INPUT_VECTOR,
+  ACC_OVERFLOW_VECTOR,
+  TIMER_OVERFLOW_VECTOR,
+  TIMER_OUTPUT5_VECTOR,
+  TIMER_OUTPUT4_VECTOR,
+  TIMER_OUTPUT3_VECTOR,
+  TIMER_OUTPUT2_VECTOR,
+  TIMER_OUTPUT1_VECTOR,
+  TIMER_INPUT3_VECTOR,
+  TIMER_INPUT2_VECTOR,
+  TIMER_INPUT1_VECTOR,
+  RTI_VECTOR,
+  IRQ_VECTOR,
+  XIRQ_VECTOR,
+  SWI_VECTOR,
+  ILLEGAL_OPCODE_VECTOR,
+  COP_FAIL_VECTOR,
+  COP_CLOCK_VECTOR,
+  RESET_VECTOR,
+  MAX_VECTORS
+};
+
+extern interrupt_t hc11_vectors[MAX_VECTORS];
+
+#define set_interrupt_handler(V, H) (hc11_vectors[V] = (H))
+
+/* pulse.c only waits for interrupts in its main loop, which the model
+   does not run (see hc11_wai in hc11sim.h).  */
+#define wai() ((void) 0)
+
+#endif
@@ -0,0 +1,148 @@
+/* Host model of the GEL <sys/ports.h>
+   Copyright (C) 2003 Free Software Foundation, Inc.
+
+This file is free software; you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the
+Free Software Foundation; either version 2, or (at your option) any
+later version.
+
+In addition to the permissions in the GNU General Public License, the
+Free Software Foundation gives you unlimited permission to link the
+compiled version of this file with other programs, and to distribute
+those programs without any restriction coming from the use of this
+file.  (The General Public License restrictions do apply in other
+respects; for example, they cover modification of the file, and
+distribution when not linked into another program.)
+
+This file is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to
+the Free Software Foundation, 59 Temple Place - Suite 330,
+Boston, MA 02111-1307, USA.  */
+
+/* This header replaces the GEL <sys/ports.h> when pulse.c is compiled
+   on the host.  The register file is a plain array owned by the model
+   (hc11sim.c) and the timer accessors are real functions so that the
+   model can charge their cycles and apply their side effects.  */
+#ifndef _HOST_SYS_PORTS_H
+#define _HOST_SYS_PORTS_H
+
+/* Register offsets in the I/O page.  */
+#define M6811_PORTA	0x00
+#define M6811_CFORC	0x0B
+#define M6811_OC1M	0x0C
+#define M6811_OC1D	0x0D
+#define M6811_TCNT	0x0E
+#define M6811_TIC1	0x10
+#define M6811_TIC2	0x12
+#define M6811_TIC3	0x14
+#define M6811_TOC1	0x16
+#define M6811_TOC2	0x18
+#define M6811_TOC3	0x1A
+#define M6811_TOC4	0x1C
+#define M6811_TOC5	0x1E
+#define M6811_TCTL1	0x20
+#define M6811_TCTL2	0x21
+#define M6811_TMSK1	0x22
+/* TFLG1 is write-one-to-clear and reads back the pending flags: the
+   model has to see each access, so the offset comes from a call, see
+   hc11_tflg1_access in hc11sim.c.  */
+#define HC11_TFLG1	0x23
+#define M6811_TFLG1	(hc11_tflg1_access ())
+#define M6811_TMSK2	0x24
+#define M6811_TFLG2	0x25
+#define M6811_PACTL	0x26
+#define M6811_BAUD	0x2B
+#define M6811_SCCR1	0x2C
+#define M6811_SCCR2	0x2D
+#define M6811_SCSR	0x2E
+#define M6811_SCDR	0x2F
+
+/* CFORC, TMSK1 and TFLG1 bits.  */
+#define M6811_FOC1	0x80
+#define M6811_FOC2	0x40
+#define M6811_FOC3	0x20
+#define M6811_FOC4	0x10
+#define M6811_FOC5	0x08
+#define M6811_OC1I	0x80
+#define M6811_OC2I	0x40
+#define M6811_OC3I	0x20
+#define M6811_OC4I	0x10
+#define M6811_I4O5I	0x08
+#define M6811_IC1I	0x04
+#define M6811_IC2I	0x02
+#define M6811_IC3I	0x01
+#define M6811_OC1F	0x80
+#define M6811_OC2F	0x40
+#define M6811_OC3F	0x20
+#define M6811_OC4F	0x10
+#define M6811_I4O5F	0x08
+#define M6811_IC1F	0x04
+#define M6811_IC2F	0x02
+#define M6811_IC3F	0x01
+
+/* TCTL1 bits.  */
+#define M6811_OM2	0x80
+#define M6811_OL2	0x40
+#define M6811_OM3	0x20
+#define M6811_OL3	0x10
+#define M6811_OM4	0x08
+#define M6811_OL4	0x04
+#define M6811_OM5	0x02
+#define M6811_OL5	0x01
+
+/* TCTL2 bits.  */
+#define M6811_EDG1B	0x20
+#define M6811_EDG1A	0x10
+#define M6811_EDG2B	0x08
+#define M6811_EDG2A	0x04
+#define M6811_EDG3B	0x02
+#define M6811_EDG3A	0x01
+
+/* PACTL bits.  */
+#define M6811_DDRA7	0x80
+#define M6811_PAEN	0x40
+#define M6811_PAMOD	0x20
+#define M6811_PEDGE	0x10
+#define M6811_DDRA3	0x08
+#define M6811_I4O5	0x04
+
+/* TMSK2 and TFLG2 bits.  */
+#define M6811_TOI	0x80
+#define M6811_RTII	0x40
+#define M6811_PR1	0x02
+#define M6811_PR0	0x01
+#define M6811_TOF	0x80
+#define M6811_RTIF	0x40
+
+/* SCCR2 and SCSR bits.  */
+#define M6811_TIE	0x80
+#define M6811_TCIE	0x40
+#define M6811_RIE	0x20
+#define M6811_ILIE	0x10
+#define M6811_TE	0x08
+#define M6811_RE	0x04
+#define M6811_TDRE	0x80
+#define M6811_TC	0x40
+#define M6811_RDRF	0x20
+#define M6811_IDLE	0x10
+#define M6811_OR	0x08
+
+extern unsigned char _io_ports[];
+extern int hc11_tflg1_access (void);
+
+extern unsigned short get_timer_counter (void);
+extern unsigned short get_input_capture_1 (void);
+extern unsigned short get_input_capture_2 (void);
+extern unsigned short get_input_capture_3 (void);
+extern void set_output_compare_1 (unsigned short value);
+extern void set_output_compare_2 (unsigned short value);
+extern void set_output_compare_3 (unsigned short value);
+extern void set_output_compare_4 (unsigned short value);
+extern void set_output_compare_5 (unsigned short value);
+
+#endif
@@ -0,0 +1,56 @@
+/* Host model of the GEL <sys/sio.h>
+   Copyright (C) 2003 Free Software Foundation, Inc.
+
+This file is free software; you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the
+Free Software Foundation; either version 2, or (at your option) any
+later version.
+
+In addition to the permissions in the GNU General Public License, the
+Free Software Foundation gives you unlimited permission to link the
+compiled version of this file with other programs, and to distribute
+those programs without any restriction coming from the use of this
+file.  (The General Public License restrictions do apply in other
+respects; for example, they cover modification of the file, and
+distribution when not linked into another program.)
+
+This file is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to
+the Free Software Foundation, 59 Temple Place - Suite 330,
+Boston, MA 02111-1307, USA.  */
+
+#ifndef _HOST_SYS_SIO_H
+#define _HOST_SYS_SIO_H
+
+#include "hc11sim.h"
+
+/* The SCI is modelled at the byte level by hc11sim.c.  */
+static inline void
+serial_init (void)
+{
+}
+
+static inline void
+serial_send (char c)
+{
+  hc11_sci_send (c);
+}
+
+static inline unsigned char
+serial_receive_pending (void)
+{
+  return hc11_sci_pending ();
+}
+
+static inline unsigned char
+serial_recv (void)
+{
+  return hc11_sci_recv ();
+}
+
+#endif
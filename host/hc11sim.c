@@ -0,0 +1,687 @@
+/* HC11 timer and interrupt model
+   Copyright (C) 2003 Free Software Foundation, Inc.
+
+This file is free software; you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the
+Free Software Foundation; either version 2, or (at your option) any
+later version.
+
+In addition to the permissions in the GNU General Public License, the
+Free Software Foundation gives you unlimited permission to link the
+compiled version of this file with other programs, and to distribute
+those programs without any restriction coming from the use of this
+file.  (The General Public License restrictions do apply in other
+respects; for example, they cover modification of the file, and
+distribution when not linked into another program.)
+
+This file is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to
+the Free Software Foundation, 59 Temple Place - Suite 330,
+Boston, MA 02111-1307, USA.  */
+
+/* This is a model of the 68HC11 free running counter, output compare
+   and interrupt logic, just enough to run the interrupt handlers of
+   pulse.c on the host.  Time only advances when the model charges the
+   cycles of an interrupt entry, of a timer access made by the handler
+   or of its exit.  The main program is considered idle between two
+   interrupts, it only adds the latency of the instruction in flight
+   (none when it waits with WAI).
+
+   Writes to CFORC are collected each time the program calls into the
+   model.  TFLG1 reads back the pending flags and is write-one-to-clear
+   as on the chip, see hc11_tflg1_access: a read-modify-write
+   acknowledge clears all the flags it has read.
+
+   The input capture pins PA2 to PA0 (IC1 to IC3) change level at the
+   cycles given to hc11_capture_input.  An edge selected by TCTL2
+   latches the counter in TICx and sets the flag, as on the chip; a
+   compare which neither drives its pin nor interrupts does not keep
+   the model running.  hc11_loopback wires a compare output to a
+   capture input.
+
+   The SCI transmitter is busy for a byte time after each byte sent
+   and raises the SCI interrupt while it is free and SCCR2 has TIE.
+   That interrupt is charged the same entry and exit costs as the
+   timer ones.  */
+#include "hc11sim.h"
+#include <sys/ports.h>
+#include <sys/interrupts.h>
+
+/* Defaults estimated from the m6811-elf-gcc -Os code of
+   output_compare_interrupt and checked against the `sim info'
+   deltas quoted in pulse.c.  */
+const struct hc11_cost hc11_default_cost = {
+  4,    /* latency: LDAB ext of the edge_count poll loop */
+  14,   /* stack */
+  3,    /* dispatch: JMP ext */
+  24,   /* prologue: 3 x (LDX dir, PSHX) */
+  31,   /* arm: flag ack, LDX, LDD, ADDD, STD TOC4 */
+  40,   /* rearm: burst loop flag ack, cursor update, ADDD, STD TOC4 */
+  14,   /* poll: LDD TCNT, SUBD, BMI */
+  48,   /* epilogue: cursor update, edge_count, 3 x (PULX, STX dir) */
+  12,   /* rti */
+  4     /* wake: vector fetch */
+};
+
+struct hc11_cost hc11_cost;
+unsigned long long hc11_now;
+unsigned long hc11_edges;
+unsigned char hc11_wai;
+void (* hc11_edge_hook) (const struct hc11_edge *edge);
+void (* hc11_idle_hook) (void);
+void (* hc11_entry_hook) (int n, unsigned long latency);
+void (* hc11_sci_hook) (unsigned char c);
+
+unsigned char _io_ports[0x40];
+interrupt_t hc11_vectors[MAX_VECTORS];
+unsigned char hc11_locked;
+
+/* Output compare channels, indexed by compare number (1 to 5).  */
+struct hc11_oc
+{
+  unsigned long long match;   /* Cycle of the next match.  */
+  unsigned long long last;    /* Cycle of the previous edge.  */
+  unsigned long long due;     /* Cycle the program meant for the match.  */
+  unsigned long long last_due; /* Same for the previous edge.  */
+  unsigned long long flagged; /* Cycle the flag was set.  */
+  unsigned short toc;         /* Compare register.  */
+  unsigned char active;       /* Written at least once.  */
+  unsigned char seen;         /* Produced at least one edge.  */
+};
+
+static struct hc11_oc hc11_oc[6];
+
+/* Input capture pins, indexed by capture number (1 to 3).  */
+struct hc11_ic
+{
+  const unsigned long long *cycles;  /* Cycles of the level changes.  */
+  unsigned long count;
+  unsigned long pos;                 /* Next change.  */
+  unsigned long long latched;        /* Cycle of the edge in TICn.  */
+  unsigned long long read;           /* Same, at the last read.  */
+};
+
+static struct hc11_ic hc11_ic[4];
+static int hc11_loop_pin;
+static int hc11_loop_ic;
+static unsigned char hc11_tflg1;
+static unsigned char hc11_tflg1_open;
+static unsigned char hc11_in_handler;
+static unsigned char hc11_armed;
+static unsigned char hc11_waiting;
+static unsigned long hc11_seed;
+
+/* Bytes waiting on the SCI receiver.  */
+static const unsigned char *hc11_rx_data;
+static unsigned long hc11_rx_len;
+static unsigned long hc11_rx_pos;
+static unsigned long long hc11_rx_start;
+static unsigned long hc11_rx_rate;
+
+/* SCI transmitter: cycle at which TDRE is set again.  */
+static unsigned long long hc11_tx_free;
+static unsigned long hc11_tx_rate;
+
+/* E clock cycles per timer count, from the TMSK2 prescaler bits.  */
+static unsigned long
+hc11_prescale (void)
+{
+  static const unsigned char rates[] = { 1, 4, 8, 16 };
+
+  return rates[_io_ports[M6811_TMSK2] & (M6811_PR1 | M6811_PR0)];
+}
+
+#define OC_FLAG(N)   (0x80 >> ((N) - 1))
+#define OC_PIN(N)    (8 - (N))
+#define OC_VECTOR(N) (TIMER_OUTPUT1_VECTOR - ((N) - 1))
+#define IC_FLAG(N)   (0x04 >> ((N) - 1))
+#define IC_PIN(N)    (3 - (N))
+#define IC_VECTOR(N) (TIMER_INPUT1_VECTOR - ((N) - 1))
+
+static void
+hc11_set_pin (int pin, int level)
+{
+  if (level)
+    _io_ports[M6811_PORTA] |= 1 << pin;
+  else
+    _io_ports[M6811_PORTA] &= ~(1 << pin);
+}
+
+static void hc11_capture (int n, unsigned long long cycle, int level);
+
+/* Apply the TCTL1 action of compare N; OC1 has none.  */
+static void
+hc11_compare_action (int n, unsigned long long cycle)
+{
+  struct hc11_oc *oc = &hc11_oc[n];
+  struct hc11_edge edge;
+  int mode;
+  int pin;
+
+  if (n < 2)
+    return;
+
+  mode = (_io_ports[M6811_TCTL1] >> ((5 - n) * 2)) & 3;
+  if (mode == 0)
+    return;
+
+  pin = OC_PIN (n);
+  if (mode == 1)
+    hc11_set_pin (pin, !(_io_ports[M6811_PORTA] & (1 << pin)));
+  else
+    hc11_set_pin (pin, mode == 3);
+
+  edge.index = hc11_edges++;
+  edge.cycle = cycle;
+  edge.pin = pin;
+  edge.level = (_io_ports[M6811_PORTA] >> pin) & 1;
+  if (oc->seen)
+    {
+      edge.delta = (unsigned long) (cycle - oc->last);
+      edge.expect = (unsigned long) (oc->due - oc->last_due);
+    }
+  else
+    {
+      edge.delta = 0;
+      edge.expect = 0;
+    }
+  oc->seen = 1;
+  oc->last = cycle;
+  oc->last_due = oc->due;
+
+  if (pin == hc11_loop_pin)
+    hc11_capture (hc11_loop_ic, cycle, edge.level);
+
+  if (hc11_edge_hook)
+    hc11_edge_hook (&edge);
+}
+
+/* Compare N drives its pin or raises its interrupt.  */
+static int
+hc11_compare_live (int n)
+{
+  if (_io_ports[M6811_TMSK1] & OC_FLAG (n))
+    return 1;
+  if (n == 1)
+    return _io_ports[M6811_OC1M] != 0;
+  return (_io_ports[M6811_TCTL1] >> ((5 - n) * 2)) & 3;
+}
+
+/* Cycle of the next compare match, or 0 if no compare is active.
+   Unless `all' is set, only the live compares are considered.  */
+static unsigned long long
+hc11_next_match (int *which, int all)
+{
+  unsigned long long t = 0;
+  int n;
+
+  for (n = 1; n <= 5; n++)
+    if (hc11_oc[n].active && (all || hc11_compare_live (n))
+        && (t == 0 || hc11_oc[n].match < t))
+      {
+        t = hc11_oc[n].match;
+        *which = n;
+      }
+  return t;
+}
+
+/* Cycle of the next input capture pin change, or 0 if none.  */
+static unsigned long long
+hc11_next_input (int *which)
+{
+  unsigned long long t = 0;
+  int n;
+
+  for (n = 1; n <= 3; n++)
+    if (hc11_ic[n].pos < hc11_ic[n].count
+        && (t == 0 || hc11_ic[n].cycles[hc11_ic[n].pos] < t))
+      {
+        t = hc11_ic[n].cycles[hc11_ic[n].pos];
+        *which = n;
+      }
+  return t;
+}
+
+/* The pin of capture N goes to `level' at `cycle'.  The TCTL2 bits
+   select the rising (1), falling (2) or both (3) edges.  */
+static void
+hc11_capture (int n, unsigned long long cycle, int level)
+{
+  int pin = IC_PIN (n);
+  int edges = (_io_ports[M6811_TCTL2] >> ((3 - n) * 2)) & 3;
+  unsigned short tic;
+
+  if (((_io_ports[M6811_PORTA] >> pin) & 1) == level)
+    return;
+  hc11_set_pin (pin, level);
+  if (!(edges & (level ? 1 : 2)))
+    return;
+
+  tic = (unsigned short) (cycle / hc11_prescale ());
+  _io_ports[M6811_TIC1 + 2 * (n - 1)] = tic >> 8;
+  _io_ports[M6811_TIC1 + 2 * (n - 1) + 1] = tic;
+  hc11_ic[n].latched = cycle;
+  hc11_tflg1 |= IC_FLAG (n);
+}
+
+/* Let the counter run up to `cycle', producing the matches and the
+   captures on the way.  */
+static void
+hc11_advance (unsigned long long cycle)
+{
+  unsigned long long t;
+  unsigned long long u;
+  int n = 0;
+  int i = 0;
+
+  for (;;)
+    {
+      t = hc11_next_match (&n, 1);
+      u = hc11_next_input (&i);
+      if (u != 0 && u <= cycle && (t == 0 || u < t))
+        {
+          /* The pins start low and change at each listed cycle.  */
+          hc11_capture (i, u, !(hc11_ic[i].pos & 1));
+          hc11_ic[i].pos++;
+          continue;
+        }
+      if (t == 0 || t > cycle)
+        break;
+      if (!(hc11_tflg1 & OC_FLAG (n)))
+        hc11_oc[n].flagged = t;
+      hc11_tflg1 |= OC_FLAG (n);
+      hc11_compare_action (n, t);
+      hc11_oc[n].match += 0x10000 * hc11_prescale ();
+    }
+  hc11_now = cycle;
+}
+
+/* Apply the last access of the program to TFLG1: the value it left in
+   the register is taken as written and clears the flags set in it.  */
+static void
+hc11_tflg1_commit (void)
+{
+  if (hc11_tflg1_open)
+    {
+      hc11_tflg1 &= ~_io_ports[HC11_TFLG1];
+      hc11_tflg1_open = 0;
+    }
+}
+
+/* Every access of the program to TFLG1 comes here for the offset of
+   the register (see <sys/ports.h>).  The previous access is applied
+   and the register then holds the pending flags, which is what the
+   program reads; whatever it holds at the next access or call into
+   the model was written.  A plain read would thus count as writing
+   back the flags read, pulse.c only writes TFLG1.  */
+int
+hc11_tflg1_access (void)
+{
+  hc11_tflg1_commit ();
+  _io_ports[HC11_TFLG1] = hc11_tflg1;
+  hc11_tflg1_open = 1;
+  return HC11_TFLG1;
+}
+
+/* Collect the register writes made by the program since the last
+   call into the model.  */
+static void
+hc11_sync (void)
+{
+  unsigned char v;
+  int n;
+
+  hc11_tflg1_commit ();
+  v = _io_ports[M6811_CFORC];
+  if (v)
+    {
+      for (n = 1; n <= 5; n++)
+        if (v & OC_FLAG (n))
+          hc11_compare_action (n, hc11_now);
+      _io_ports[M6811_CFORC] = 0;
+    }
+}
+
+static void
+hc11_set_compare (int n, unsigned short value)
+{
+  struct hc11_oc *oc = &hc11_oc[n];
+  unsigned long rate = hc11_prescale ();
+  unsigned long wait;
+
+  /* The writes made before this one take effect first.  */
+  hc11_sync ();
+  if (hc11_in_handler)
+    {
+      hc11_advance (hc11_now + (hc11_armed ? hc11_cost.rearm
+                                : hc11_cost.arm));
+      hc11_armed = 1;
+    }
+
+  /* Successive compare values are relative to each other: this is
+     how the program means them, even when one is set too late.  A
+     compare set while its interrupt is off starts a new sequence.  */
+  wait = (unsigned short) (value - oc->toc);
+  if (oc->active)
+    oc->due += (wait ? wait : 0x10000) * rate;
+  if (!(_io_ports[M6811_TMSK1] & OC_FLAG (n)))
+    oc->active = 0;
+
+  oc->toc = value;
+  _io_ports[M6811_TOC1 + 2 * (n - 1)] = value >> 8;
+  _io_ports[M6811_TOC1 + 2 * (n - 1) + 1] = value;
+
+  /* A compare equal to the counter, or already in the past, only
+     matches after the counter wraps.  The counter moves on every
+     `rate' E clock cycles.  */
+  wait = (unsigned short) (value - (unsigned short) (hc11_now / rate));
+  oc->match = (hc11_now / rate + (wait ? wait : 0x10000)) * rate;
+  if (!oc->active)
+    oc->due = oc->match;
+  oc->active = 1;
+}
+
+unsigned short
+get_timer_counter (void)
+{
+  hc11_sync ();
+  if (hc11_in_handler)
+    hc11_advance (hc11_now + hc11_cost.poll);
+  return (unsigned short) (hc11_now / hc11_prescale ());
+}
+
+static unsigned short
+hc11_get_capture (int n)
+{
+  hc11_sync ();
+  hc11_ic[n].read = hc11_ic[n].latched;
+  return (_io_ports[M6811_TIC1 + 2 * (n - 1)] << 8)
+    | _io_ports[M6811_TIC1 + 2 * (n - 1) + 1];
+}
+
+unsigned long long
+hc11_capture_cycle (int n)
+{
+  return hc11_ic[n].read;
+}
+
+unsigned short
+get_input_capture_1 (void)
+{
+  return hc11_get_capture (1);
+}
+
+unsigned short
+get_input_capture_2 (void)
+{
+  return hc11_get_capture (2);
+}
+
+unsigned short
+get_input_capture_3 (void)
+{
+  return hc11_get_capture (3);
+}
+
+void
+set_output_compare_1 (unsigned short value)
+{
+  hc11_set_compare (1, value);
+}
+
+void
+set_output_compare_2 (unsigned short value)
+{
+  hc11_set_compare (2, value);
+}
+
+void
+set_output_compare_3 (unsigned short value)
+{
+  hc11_set_compare (3, value);
+}
+
+void
+set_output_compare_4 (unsigned short value)
+{
+  hc11_set_compare (4, value);
+}
+
+void
+set_output_compare_5 (unsigned short value)
+{
+  hc11_set_compare (5, value);
+}
+
+void
+hc11_capture_input (int n, const unsigned long long *cycles,
+                    unsigned long count)
+{
+  hc11_ic[n].cycles = cycles;
+  hc11_ic[n].count = count;
+  hc11_ic[n].pos = 0;
+}
+
+void
+hc11_loopback (int pin, int n)
+{
+  hc11_loop_pin = pin;
+  hc11_loop_ic = n;
+}
+
+void
+hc11_sci_input (const unsigned char *data, unsigned long len,
+                unsigned long long start, unsigned long cycles_per_byte)
+{
+  hc11_rx_data = data;
+  hc11_rx_len = len;
+  hc11_rx_pos = 0;
+  hc11_rx_start = start;
+  hc11_rx_rate = cycles_per_byte;
+}
+
+unsigned long
+hc11_sci_input_left (void)
+{
+  return hc11_rx_len - hc11_rx_pos;
+}
+
+/* Arrival cycle of the next byte on the receiver, 0 when none.  */
+static unsigned long long
+hc11_rx_next (void)
+{
+  if (hc11_rx_pos >= hc11_rx_len)
+    return 0;
+  return hc11_rx_start + (hc11_rx_pos + 1) * hc11_rx_rate;
+}
+
+unsigned char
+hc11_sci_pending (void)
+{
+  return hc11_rx_pos < hc11_rx_len
+    && hc11_rx_start + (hc11_rx_pos + 1) * hc11_rx_rate <= hc11_now;
+}
+
+unsigned char
+hc11_sci_recv (void)
+{
+  return hc11_sci_pending () ? hc11_rx_data[hc11_rx_pos++] : 0;
+}
+
+void
+hc11_sci_output (unsigned long cycles_per_byte)
+{
+  hc11_tx_rate = cycles_per_byte;
+}
+
+void
+hc11_sci_send (unsigned char c)
+{
+  if (hc11_sci_hook)
+    hc11_sci_hook (c);
+  if (hc11_tx_free < hc11_now)
+    hc11_tx_free = hc11_now;
+  hc11_tx_free += hc11_tx_rate;
+}
+
+/* The SCI interrupt is raised while TIE is set and TDRE is.  */
+static int
+hc11_sci_ready (void)
+{
+  return (_io_ports[M6811_SCCR2] & M6811_TIE)
+    && hc11_vectors[SCI_VECTOR] != 0;
+}
+
+/* Highest priority pending and enabled interrupt, or -1.  */
+static int
+hc11_pending (void)
+{
+  unsigned char f;
+  int n;
+
+  if (hc11_locked)
+    return -1;
+
+  hc11_tflg1_commit ();
+  f = hc11_tflg1 & _io_ports[M6811_TMSK1];
+  for (n = 1; n <= 3; n++)
+    if ((f & IC_FLAG (n)) && hc11_vectors[IC_VECTOR (n)])
+      return IC_VECTOR (n);
+  for (n = 1; n <= 5; n++)
+    if ((f & OC_FLAG (n)) && hc11_vectors[OC_VECTOR (n)])
+      return OC_VECTOR (n);
+  if (hc11_sci_ready () && hc11_tx_free <= hc11_now)
+    return SCI_VECTOR;
+  return -1;
+}
+
+static unsigned short
+hc11_latency (void)
+{
+  if (hc11_cost.latency == 0)
+    return 0;
+  hc11_seed = hc11_seed * 1103515245 + 12345;
+  return 1 + (hc11_seed >> 16) % hc11_cost.latency;
+}
+
+static void
+hc11_interrupt (int vector)
+{
+  int n;
+
+  hc11_advance (hc11_now + (hc11_waiting ? hc11_cost.wake : hc11_cost.stack)
+                + hc11_cost.dispatch + hc11_cost.prologue);
+  hc11_waiting = 0;
+  hc11_in_handler = 1;
+  hc11_armed = 0;
+  hc11_locked = 1;
+
+  for (n = 1; n <= 5; n++)
+    if (vector == OC_VECTOR (n) && hc11_entry_hook)
+      hc11_entry_hook (n, hc11_now - hc11_oc[n].flagged);
+
+  hc11_vectors[vector] ();
+
+  hc11_sync ();
+  hc11_advance (hc11_now + (hc11_armed ? 0 : hc11_cost.arm)
+                + hc11_cost.epilogue + hc11_cost.rti);
+  hc11_in_handler = 0;
+  hc11_locked = 0;
+}
+
+void
+hc11_reset (unsigned long seed)
+{
+  int i;
+
+  for (i = 0; i < 0x40; i++)
+    _io_ports[i] = 0;
+  for (i = 0; i < MAX_VECTORS; i++)
+    hc11_vectors[i] = 0;
+  for (i = 0; i <= 5; i++)
+    {
+      hc11_oc[i].match = 0;
+      hc11_oc[i].last = 0;
+      hc11_oc[i].due = 0;
+      hc11_oc[i].last_due = 0;
+      hc11_oc[i].flagged = 0;
+      hc11_oc[i].toc = 0xffff;
+      hc11_oc[i].active = 0;
+      hc11_oc[i].seen = 0;
+    }
+  for (i = 0; i <= 3; i++)
+    {
+      hc11_ic[i].count = 0;
+      hc11_ic[i].latched = 0;
+      hc11_ic[i].read = 0;
+    }
+  hc11_loop_pin = -1;
+  hc11_cost = hc11_default_cost;
+  hc11_wai = 0;
+  hc11_now = 0;
+  hc11_edges = 0;
+  hc11_tflg1 = 0;
+  hc11_tflg1_open = 0;
+  hc11_in_handler = 0;
+  hc11_waiting = 0;
+  hc11_locked = 1;
+  hc11_seed = seed;
+  hc11_rx_len = 0;
+  hc11_rx_pos = 0;
+  hc11_tx_free = 0;
+  hc11_tx_rate = 0;
+}
+
+void
+hc11_run (unsigned long count)
+{
+  unsigned long end = hc11_edges + count;
+  unsigned long long t;
+  unsigned long long r;
+  unsigned long long u;
+  int vector;
+  int n;
+
+  while (hc11_edges < end)
+    {
+      vector = hc11_pending ();
+      if (vector >= 0)
+        {
+          hc11_interrupt (vector);
+          continue;
+        }
+
+      /* Nothing pending: the main program runs until the next match
+         and the interrupt is taken once the current instruction
+         completes.  */
+      if (hc11_idle_hook)
+        hc11_idle_hook ();
+      t = hc11_next_match (&n, 0);
+      u = hc11_next_input (&n);
+      if (u != 0 && (t == 0 || u < t))
+        t = u;
+      if (hc11_sci_ready () && (t == 0 || hc11_tx_free < t))
+        t = hc11_tx_free > hc11_now ? hc11_tx_free : hc11_now;
+
+      /* The main loop polls the receiver all the time: it gets each
+         byte as it arrives (with WAI, only once per interrupt).  */
+      r = hc11_rx_next ();
+      if (!hc11_wai && r > hc11_now && (t == 0 || r < t))
+        {
+          hc11_advance (r);
+          continue;
+        }
+      if (t == 0)
+        break;
+      hc11_advance (t);
+      if (hc11_wai)
+        hc11_waiting = 1;
+      else
+        hc11_advance (hc11_now + hc11_latency ());
+    }
+}
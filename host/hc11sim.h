@@ -0,0 +1,126 @@
+/* HC11 timer and interrupt model
+   Copyright (C) 2003 Free Software Foundation, Inc.
+
+This file is free software; you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the
+Free Software Foundation; either version 2, or (at your option) any
+later version.
+
+In addition to the permissions in the GNU General Public License, the
+Free Software Foundation gives you unlimited permission to link the
+compiled version of this file with other programs, and to distribute
+those programs without any restriction coming from the use of this
+file.  (The General Public License restrictions do apply in other
+respects; for example, they cover modification of the file, and
+distribution when not linked into another program.)
+
+This file is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to
+the Free Software Foundation, 59 Temple Place - Suite 330,
+Boston, MA 02111-1307, USA.  */
+
+#ifndef _HC11SIM_H
+#define _HC11SIM_H
+
+/* Cycle cost of the interrupt path, in E clock cycles.  The handler
+   itself runs natively on the host; these values account for the
+   68HC11 instructions it would have executed.  */
+struct hc11_cost
+{
+  unsigned short latency;   /* Longest instruction in flight at a match.  */
+  unsigned short stack;     /* Interrupt frame push and vector fetch.  */
+  unsigned short dispatch;  /* JMP through the monitor RAM pseudo-vector.  */
+  unsigned short prologue;  /* Soft register saves of the handler.  */
+  unsigned short arm;       /* Handler body up to the first compare write.  */
+  unsigned short rearm;     /* Each further compare write (burst loop).  */
+  unsigned short poll;      /* Each TCNT read in the handler.  */
+  unsigned short epilogue;  /* Rest of the body and soft register restores.  */
+  unsigned short rti;       /* Return from interrupt.  */
+  unsigned short wake;      /* Vector fetch out of WAI, frame pushed.  */
+};
+
+/* An output compare action on a port A pin.  */
+struct hc11_edge
+{
+  unsigned long index;        /* Edge number, all pins together.  */
+  unsigned long long cycle;   /* E clock cycle of the compare match.  */
+  unsigned long delta;        /* Cycles since the previous edge on the pin.  */
+  unsigned long expect;       /* Interval the program asked for.  */
+  unsigned char pin;          /* Port A bit.  */
+  unsigned char level;        /* Pin level after the edge.  */
+};
+
+extern const struct hc11_cost hc11_default_cost;
+extern struct hc11_cost hc11_cost;
+
+/* Current E clock cycle.  */
+extern unsigned long long hc11_now;
+
+/* Number of edges produced since the reset.  */
+extern unsigned long hc11_edges;
+
+/* When set, the main program waits for the interrupts with WAI: an
+   interrupt taken while it is idle has no instruction in flight and
+   only costs `wake' instead of `stack'.  */
+extern unsigned char hc11_wai;
+
+/* Called for every edge, may be null.  */
+extern void (* hc11_edge_hook) (const struct hc11_edge *edge);
+
+/* Called each time the main program gets the CPU between two
+   interrupts, may be null.  It runs at no cycle cost.  */
+extern void (* hc11_idle_hook) (void);
+
+/* Called when the handler of compare N starts, with the cycles since
+   the compare matched, may be null.  */
+extern void (* hc11_entry_hook) (int n, unsigned long latency);
+
+/* Called for every byte the program sends on the SCI, may be null.  */
+extern void (* hc11_sci_hook) (unsigned char c);
+
+/* Drive the pin of input capture N (1 to 3, PA2 to PA0) from the
+   sorted list of `count' cycles: the pin starts low and changes level
+   at each of them.  The list must stay valid while the model runs.  */
+extern void hc11_capture_input (int n, const unsigned long long *cycles,
+                                unsigned long count);
+
+/* Cycle of the input edge whose capture the program read last from
+   TICn: later edges may have replaced it in the register since.  */
+extern unsigned long long hc11_capture_cycle (int n);
+
+/* Wire port A pin `pin' to the input of capture N: each compare edge
+   of the pin is also an edge on the capture pin, at the same cycle.  */
+extern void hc11_loopback (int pin, int n);
+
+/* Queue `len' bytes on the SCI receiver.  They arrive one every
+   `cycles_per_byte' cycles starting at cycle `start'.  */
+extern void hc11_sci_input (const unsigned char *data, unsigned long len,
+                            unsigned long long start,
+                            unsigned long cycles_per_byte);
+
+/* Number of the queued bytes the program has not read yet.  */
+extern unsigned long hc11_sci_input_left (void);
+
+/* Each byte sent keeps the SCI transmitter busy for `cycles_per_byte'
+   cycles (none by default).  */
+extern void hc11_sci_output (unsigned long cycles_per_byte);
+
+/* Polled SCI used by the mock <sys/sio.h>.  */
+extern unsigned char hc11_sci_pending (void);
+extern unsigned char hc11_sci_recv (void);
+extern void hc11_sci_send (unsigned char c);
+
+/* Reset the timer, port A and the vectors.  The seed drives the
+   instruction-in-flight latency so that runs are reproducible.  */
+extern void hc11_reset (unsigned long seed);
+
+/* Run the interrupt driven program until `count' more edges were
+   produced.  */
+extern void hc11_run (unsigned long count);
+
+#endif
@@ -0,0 +1,694 @@
+/* Pulse Generator interrupt cycle analyzer
+   Copyright (C) 2003 Free Software Foundation, Inc.
+
+This file is free software; you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the
+Free Software Foundation; either version 2, or (at your option) any
+later version.
+
+In addition to the permissions in the GNU General Public License, the
+Free Software Foundation gives you unlimited permission to link the
+compiled version of this file with other programs, and to distribute
+those programs without any restriction coming from the use of this
+file.  (The General Public License restrictions do apply in other
+respects; for example, they cover modification of the file, and
+distribution when not linked into another program.)
+
+This file is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to
+the Free Software Foundation, 59 Temple Place - Suite 330,
+Boston, MA 02111-1307, USA.  */
+
+/* Computes the worst case number of E clock cycles from an output
+   compare match to the new compare being written, from the
+   disassembly of the program:
+
+     m6811-elf-objdump -d pulse.elf | isrcycles [-r] [-f handler] [-b base]
+
+   The handler (output_compare_interrupt by default) is walked from
+   its entry along every path, following the calls, up to the first
+   store into TOC4 (the compare is armed); the longest path gives the
+   handler part.  To this are added:
+
+   - the longest instruction found outside the interrupt handlers,
+     which may be in flight when the compare matches;
+   - the longest of the other interrupt handlers (`*_interrupt'),
+     which may just have started and can't be preempted;
+   - the interrupt frame push and vector fetch (14 cycles) and, unless
+     -r tells this is the ROM build with the direct vector table, the
+     JMP ext of the monitor RAM pseudo-vector (3 cycles).
+
+   The total is printed on the standard output, to be used as the
+   minimum interval of host/pulsegen (-m), and the details on the
+   error output.  An indirect call or an unknown instruction is an
+   error: the worst case would not be bounded.  A loop is only warned
+   about: on the way to the compare it is counted once (the overrun
+   catch up of pulse_overrun), and another interrupt handler with a
+   loop (the SCI polling TDRE) is left out of the blocking time.  The
+   cycles come from the 68HC11 reference manual; `base' is the
+   address of the registers (0x1000).  */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_INSNS 65536
+#define MAX_FUNCS 1024
+
+/* Addressing modes.  */
+enum mode { IMM, DIR, EXT, IX, IY, INH, NMODES };
+
+/* Cycles of an instruction in each mode, 0 when it does not exist.  */
+struct timing
+{
+  const char *name;
+  unsigned char cycles[NMODES];
+};
+
+static const struct timing timings[] = {
+  /*               IMM DIR EXT IX IY INH */
+  { "adca",      {  2,  3,  4,  4,  5,  0 } },
+  { "adcb",      {  2,  3,  4,  4,  5,  0 } },
+  { "adda",      {  2,  3,  4,  4,  5,  0 } },
+  { "addb",      {  2,  3,  4,  4,  5,  0 } },
+  { "anda",      {  2,  3,  4,  4,  5,  0 } },
+  { "andb",      {  2,  3,  4,  4,  5,  0 } },
+  { "bita",      {  2,  3,  4,  4,  5,  0 } },
+  { "bitb",      {  2,  3,  4,  4,  5,  0 } },
+  { "cmpa",      {  2,  3,  4,  4,  5,  0 } },
+  { "cmpb",      {  2,  3,  4,  4,  5,  0 } },
+  { "eora",      {  2,  3,  4,  4,  5,  0 } },
+  { "eorb",      {  2,  3,  4,  4,  5,  0 } },
+  { "ldaa",      {  2,  3,  4,  4,  5,  0 } },
+  { "ldab",      {  2,  3,  4,  4,  5,  0 } },
+  { "oraa",      {  2,  3,  4,  4,  5,  0 } },
+  { "orab",      {  2,  3,  4,  4,  5,  0 } },
+  { "sbca",      {  2,  3,  4,  4,  5,  0 } },
+  { "sbcb",      {  2,  3,  4,  4,  5,  0 } },
+  { "suba",      {  2,  3,  4,  4,  5,  0 } },
+  { "subb",      {  2,  3,  4,  4,  5,  0 } },
+  { "staa",      {  0,  3,  4,  4,  5,  0 } },
+  { "stab",      {  0,  3,  4,  4,  5,  0 } },
+  { "addd",      {  4,  5,  6,  6,  7,  0 } },
+  { "subd",      {  4,  5,  6,  6,  7,  0 } },
+  { "cpd",       {  5,  6,  7,  7,  7,  0 } },
+  { "cpx",       {  4,  5,  6,  6,  7,  0 } },
+  { "cpy",       {  5,  6,  7,  7,  7,  0 } },
+  { "ldd",       {  3,  4,  5,  5,  6,  0 } },
+  { "lds",       {  3,  4,  5,  5,  6,  0 } },
+  { "ldx",       {  3,  4,  5,  5,  6,  0 } },
+  { "ldy",       {  4,  5,  6,  6,  6,  0 } },
+  { "std",       {  0,  4,  5,  5,  6,  0 } },
+  { "sts",       {  0,  4,  5,  5,  6,  0 } },
+  { "stx",       {  0,  4,  5,  5,  6,  0 } },
+  { "sty",       {  0,  5,  6,  6,  6,  0 } },
+  { "jsr",       {  0,  5,  6,  6,  7,  0 } },
+  { "jmp",       {  0,  0,  3,  3,  4,  0 } },
+  { "asl",       {  0,  0,  6,  6,  7,  0 } },
+  { "asr",       {  0,  0,  6,  6,  7,  0 } },
+  { "clr",       {  0,  0,  6,  6,  7,  0 } },
+  { "com",       {  0,  0,  6,  6,  7,  0 } },
+  { "dec",       {  0,  0,  6,  6,  7,  0 } },
+  { "inc",       {  0,  0,  6,  6,  7,  0 } },
+  { "lsl",       {  0,  0,  6,  6,  7,  0 } },
+  { "lsr",       {  0,  0,  6,  6,  7,  0 } },
+  { "neg",       {  0,  0,  6,  6,  7,  0 } },
+  { "rol",       {  0,  0,  6,  6,  7,  0 } },
+  { "ror",       {  0,  0,  6,  6,  7,  0 } },
+  { "tst",       {  0,  0,  6,  6,  7,  0 } },
+  { "bclr",      {  0,  6,  0,  7,  8,  0 } },
+  { "bset",      {  0,  6,  0,  7,  8,  0 } },
+  { "brclr",     {  0,  6,  0,  7,  8,  0 } },
+  { "brset",     {  0,  6,  0,  7,  8,  0 } },
+  { "asld",      {  0,  0,  0,  0,  0,  3 } },
+  { "lsld",      {  0,  0,  0,  0,  0,  3 } },
+  { "lsrd",      {  0,  0,  0,  0,  0,  3 } },
+  { "aba",       {  0,  0,  0,  0,  0,  2 } },
+  { "abx",       {  0,  0,  0,  0,  0,  3 } },
+  { "aby",       {  0,  0,  0,  0,  0,  4 } },
+  { "cba",       {  0,  0,  0,  0,  0,  2 } },
+  { "clc",       {  0,  0,  0,  0,  0,  2 } },
+  { "cli",       {  0,  0,  0,  0,  0,  2 } },
+  { "clv",       {  0,  0,  0,  0,  0,  2 } },
+  { "daa",       {  0,  0,  0,  0,  0,  2 } },
+  { "des",       {  0,  0,  0,  0,  0,  3 } },
+  { "dex",       {  0,  0,  0,  0,  0,  3 } },
+  { "dey",       {  0,  0,  0,  0,  0,  4 } },
+  { "fdiv",      {  0,  0,  0,  0,  0, 41 } },
+  { "idiv",      {  0,  0,  0,  0,  0, 41 } },
+  { "ins",       {  0,  0,  0,  0,  0,  3 } },
+  { "inx",       {  0,  0,  0,  0,  0,  3 } },
+  { "iny",       {  0,  0,  0,  0,  0,  4 } },
+  { "mul",       {  0,  0,  0,  0,  0, 10 } },
+  { "nop",       {  0,  0,  0,  0,  0,  2 } },
+  { "psha",      {  0,  0,  0,  0,  0,  3 } },
+  { "pshb",      {  0,  0,  0,  0,  0,  3 } },
+  { "pshx",      {  0,  0,  0,  0,  0,  4 } },
+  { "pshy",      {  0,  0,  0,  0,  0,  5 } },
+  { "pula",      {  0,  0,  0,  0,  0,  4 } },
+  { "pulb",      {  0,  0,  0,  0,  0,  4 } },
+  { "pulx",      {  0,  0,  0,  0,  0,  5 } },
+  { "puly",      {  0,  0,  0,  0,  0,  6 } },
+  { "rti",       {  0,  0,  0,  0,  0, 12 } },
+  { "rts",       {  0,  0,  0,  0,  0,  5 } },
+  { "sba",       {  0,  0,  0,  0,  0,  2 } },
+  { "sec",       {  0,  0,  0,  0,  0,  2 } },
+  { "sei",       {  0,  0,  0,  0,  0,  2 } },
+  { "sev",       {  0,  0,  0,  0,  0,  2 } },
+  { "swi",       {  0,  0,  0,  0,  0, 14 } },
+  { "tab",       {  0,  0,  0,  0,  0,  2 } },
+  { "tap",       {  0,  0,  0,  0,  0,  2 } },
+  { "tba",       {  0,  0,  0,  0,  0,  2 } },
+  { "tpa",       {  0,  0,  0,  0,  0,  2 } },
+  { "tsx",       {  0,  0,  0,  0,  0,  3 } },
+  { "tsy",       {  0,  0,  0,  0,  0,  4 } },
+  { "txs",       {  0,  0,  0,  0,  0,  3 } },
+  { "tys",       {  0,  0,  0,  0,  0,  4 } },
+  { "wai",       {  0,  0,  0,  0,  0, 14 } },
+  { "xgdx",      {  0,  0,  0,  0,  0,  3 } },
+  { "xgdy",      {  0,  0,  0,  0,  0,  4 } },
+  { 0,           {  0,  0,  0,  0,  0,  0 } }
+};
+
+/* The accumulator forms (`inca', `tstb'...) of the read-modify-write
+   instructions take 2 cycles.  */
+static const char *const rmw_acc[] = {
+  "asl", "asr", "clr", "com", "dec", "inc", "lsl", "lsr", "neg", "rol",
+  "ror", "tst", 0
+};
+
+static const char *const branches[] = {
+  "bcc", "bcs", "beq", "bge", "bgt", "bhi", "bhs", "ble", "blo", "bls",
+  "blt", "bmi", "bne", "bpl", "bra", "brn", "bvc", "bvs", 0
+};
+
+struct insn
+{
+  unsigned long addr;
+  char name[8];
+  enum mode mode;
+  unsigned char cycles;
+  unsigned char arms;         /* Store into TOC4.  */
+  unsigned char kind;         /* See below.  */
+  unsigned long target;       /* Branch, jump or call target.  */
+  int func;
+};
+
+enum
+{
+  K_NEXT,                     /* Goes on with the next instruction.  */
+  K_BRANCH,                   /* Conditional: target or next.  */
+  K_JUMP,                     /* Always to target.  */
+  K_CALL,                     /* Calls target, then next.  */
+  K_RETURN,                   /* rts or rti.  */
+  K_UNKNOWN                   /* Indirect jump or call.  */
+};
+
+struct func
+{
+  char name[64];
+  int first;
+  int last;
+};
+
+/* Walk results of each instruction: longest cycles from it to the
+   compare write and to the return, -1 when there is no such path,
+   and whether a loop can be met before the compare write or before
+   the return (the figure is then not bounded).  */
+struct walk
+{
+  long arm;
+  long exit;
+  unsigned char loop_arm;
+  unsigned char loop_exit;
+  unsigned char state;        /* 0 not walked, 1 in progress, 2 done.  */
+};
+
+static struct insn insns[MAX_INSNS];
+static struct walk walks[MAX_INSNS];
+static int ninsns;
+static struct func funcs[MAX_FUNCS];
+static int nfuncs;
+static unsigned long io_base = 0x1000;
+static const char *handler = "output_compare_interrupt";
+
+static void
+fatal (const char *msg, const struct insn *in)
+{
+  if (in)
+    fprintf (stderr, "isrcycles: %s at 0x%lx (%s in %s)\n", msg, in->addr,
+             in->name, funcs[in->func].name);
+  else
+    fprintf (stderr, "isrcycles: %s\n", msg);
+  exit (1);
+}
+
+static int
+in_list (const char *const *list, const char *name)
+{
+  for (; *list; list++)
+    if (strcmp (*list, name) == 0)
+      return 1;
+  return 0;
+}
+
+/* Last `0x...' number of the operands, or of the `<sym+off>' part.  */
+static unsigned long
+last_number (const char *ops)
+{
+  const char *p = ops;
+  const char *last = 0;
+
+  while ((p = strstr (p, "0x")) != 0)
+    {
+      if (p == ops || (p[-1] != '<' && p[-1] != '+'))
+        last = p;
+      p += 2;
+    }
+  return last ? strtoul (last, 0, 16) : 0;
+}
+
+static enum mode
+operand_mode (const char *ops)
+{
+  if (*ops == 0)
+    return INH;
+  if (*ops == '#')
+    return IMM;
+  if (*ops == '*')
+    return DIR;
+  if (strstr (ops, ",x"))
+    return IX;
+  if (strstr (ops, ",y"))
+    return IY;
+  return EXT;
+}
+
+/* Register X or Y content when it was loaded with an immediate value,
+   to find the `std 26,x' forms of the compare write.  */
+static long reg_x = -1;
+static long reg_y = -1;
+
+static void
+decode (struct insn *in, const char *ops)
+{
+  const struct timing *t;
+  unsigned long a;
+  size_t len = strlen (in->name);
+
+  in->mode = operand_mode (ops);
+  in->kind = K_NEXT;
+
+  if (in_list (branches, in->name))
+    {
+      in->cycles = 3;
+      in->target = last_number (ops);
+      in->kind = strcmp (in->name, "bra") == 0 ? K_JUMP : K_BRANCH;
+      if (strcmp (in->name, "brn") == 0)
+        in->kind = K_NEXT;
+      return;
+    }
+  if (strcmp (in->name, "bsr") == 0)
+    {
+      in->cycles = 6;
+      in->target = last_number (ops);
+      in->kind = K_CALL;
+      return;
+    }
+
+  for (t = timings; t->name; t++)
+    if (strcmp (t->name, in->name) == 0)
+      break;
+  if (t->name == 0 && len > 1
+      && (in->name[len - 1] == 'a' || in->name[len - 1] == 'b'))
+    {
+      char base[8];
+
+      memcpy (base, in->name, len - 1);
+      base[len - 1] = 0;
+      if (in_list (rmw_acc, base))
+        {
+          in->cycles = 2;
+          in->mode = INH;
+          return;
+        }
+    }
+  if (t->name == 0 || t->cycles[in->mode] == 0)
+    fatal ("unknown instruction", in);
+  in->cycles = t->cycles[in->mode];
+
+  if (strcmp (in->name, "rts") == 0 || strcmp (in->name, "rti") == 0)
+    in->kind = K_RETURN;
+  else if (strcmp (in->name, "brset") == 0 || strcmp (in->name, "brclr") == 0)
+    {
+      in->kind = K_BRANCH;
+      in->target = last_number (ops);
+    }
+  else if (strcmp (in->name, "jsr") == 0 || strcmp (in->name, "jmp") == 0)
+    {
+      in->kind = in->mode == EXT ? (in->name[1] == 's' ? K_CALL : K_JUMP)
+        : K_UNKNOWN;
+      in->target = last_number (ops);
+    }
+
+  /* Compare writes and X/Y tracking.  */
+  if (strcmp (in->name, "ldx") == 0 || strcmp (in->name, "ldy") == 0)
+    {
+      long v = in->mode == IMM ? (long) last_number (ops) : -1;
+
+      if (in->mode == IMM && strncmp (ops, "#0x", 3) != 0
+          && strncmp (ops, "#0", 2) != 0)
+        v = -1;
+      if (in->name[2] == 'x')
+        reg_x = v;
+      else
+        reg_y = v;
+    }
+  if (in->name[0] == 's' && in->name[1] == 't' && in->mode != INH)
+    {
+      if (in->mode == EXT)
+        a = last_number (ops);
+      else if (in->mode == IX && reg_x >= 0)
+        a = reg_x + strtoul (ops, 0, 0);
+      else if (in->mode == IY && reg_y >= 0)
+        a = reg_y + strtoul (ops, 0, 0);
+      else
+        a = 0;
+      if (strstr (ops, "<_io_ports+0x1c>") || strstr (ops, "<_io_ports+0x1d>"))
+        a = io_base + 0x1c;
+      if (a == io_base + 0x1c || a == io_base + 0x1d)
+        in->arms = 1;
+    }
+}
+
+static int
+find_insn (unsigned long addr)
+{
+  int lo = 0;
+  int hi = ninsns - 1;
+
+  while (lo <= hi)
+    {
+      int mid = (lo + hi) / 2;
+
+      if (insns[mid].addr == addr)
+        return mid;
+      if (insns[mid].addr < addr)
+        lo = mid + 1;
+      else
+        hi = mid - 1;
+    }
+  return -1;
+}
+
+static int
+find_func (const char *name)
+{
+  int i;
+
+  for (i = 0; i < nfuncs; i++)
+    if (strcmp (funcs[i].name, name) == 0)
+      return i;
+  return -1;
+}
+
+static long
+max (long a, long b)
+{
+  return a > b ? a : b;
+}
+
+/* Add `c' cycles to a walk result, keeping -1 for no path.  */
+static long
+plus (long c, long r)
+{
+  return r < 0 ? -1 : c + r;
+}
+
+static const struct walk *walk (int i);
+
+static const struct walk *
+walk_at (const struct insn *from, unsigned long addr)
+{
+  int i = find_insn (addr);
+
+  if (i < 0)
+    fatal ("branch outside of the disassembly", from);
+  return walk (i);
+}
+
+/* Longest paths from instruction `i'.  The compare write ends the
+   path to the compare, so the loops which come after it only make the
+   whole handler unbounded.  */
+static const struct walk *
+walk (int i)
+{
+  static const struct walk loop = { -1, -1, 1, 1, 2 };
+  struct insn *in = &insns[i];
+  struct walk *w = &walks[i];
+  const struct walk *a;
+  const struct walk *b;
+  long arm;
+
+  if (w->state == 2)
+    return w;
+  if (w->state == 1)
+    return &loop;
+  w->state = 1;
+
+  switch (in->kind)
+    {
+    case K_RETURN:
+      w->arm = -1;
+      w->exit = in->cycles;
+      break;
+
+    case K_JUMP:
+      a = walk_at (in, in->target);
+      w->arm = plus (in->cycles, a->arm);
+      w->exit = plus (in->cycles, a->exit);
+      w->loop_arm = a->loop_arm;
+      w->loop_exit = a->loop_exit;
+      break;
+
+    case K_BRANCH:
+      a = walk_at (in, in->target);
+      if (i + 1 >= ninsns || insns[i + 1].func != in->func)
+        fatal ("branch falls off the function", in);
+      b = walk (i + 1);
+      w->arm = plus (in->cycles, max (a->arm, b->arm));
+      w->exit = plus (in->cycles, max (a->exit, b->exit));
+      w->loop_arm = a->loop_arm | b->loop_arm;
+      w->loop_exit = a->loop_exit | b->loop_exit;
+      break;
+
+    case K_CALL:
+      a = walk_at (in, in->target);
+      if (i + 1 >= ninsns || insns[i + 1].func != in->func)
+        fatal ("call at the end of the function", in);
+      b = walk (i + 1);
+      arm = max (a->arm, a->exit < 0 ? -1 : plus (a->exit, b->arm));
+      w->arm = plus (in->cycles, arm);
+      w->exit = plus (in->cycles, a->exit < 0 ? -1 : plus (a->exit, b->exit));
+      w->loop_arm = a->loop_arm | a->loop_exit | b->loop_arm;
+      w->loop_exit = a->loop_exit | b->loop_exit;
+      break;
+
+    case K_UNKNOWN:
+      fatal ("indirect jump or call", in);
+      break;
+
+    default:
+      if (i + 1 >= ninsns || insns[i + 1].func != in->func)
+        fatal ("code falls off the function", in);
+      b = walk (i + 1);
+      w->arm = plus (in->cycles, b->arm);
+      w->exit = plus (in->cycles, b->exit);
+      w->loop_arm = b->loop_arm;
+      w->loop_exit = b->loop_exit;
+      break;
+    }
+  if (in->arms)
+    {
+      w->arm = in->cycles;
+      w->loop_arm = 0;
+    }
+  w->state = 2;
+  return w;
+}
+
+static int
+is_handler (const char *name)
+{
+  size_t len = strlen (name);
+
+  return len > 10 && strcmp (name + len - 10, "_interrupt") == 0
+    && strcmp (name, "fatal_interrupt") != 0;
+}
+
+static void
+read_disassembly (FILE *fp)
+{
+  char line[512];
+  char name[64];
+  char ops[256];
+  unsigned long addr;
+  char *p;
+  char *q;
+  struct insn *in;
+
+  while (fgets (line, sizeof line, fp))
+    {
+      line[strcspn (line, "\r\n")] = 0;
+      if (sscanf (line, "%lx <%63[^>]>:", &addr, name) == 2
+          && line[0] != ' ')
+        {
+          if (nfuncs == MAX_FUNCS)
+            fatal ("too many functions", 0);
+          strcpy (funcs[nfuncs].name, name);
+          funcs[nfuncs].first = ninsns;
+          funcs[nfuncs].last = ninsns - 1;
+          nfuncs++;
+          reg_x = reg_y = -1;
+          continue;
+        }
+
+      /* `  addr:<TAB>bytes<TAB>mnemonic<TAB>operands'  */
+      if (nfuncs == 0 || sscanf (line, " %lx:", &addr) != 1)
+        continue;
+      p = strchr (line, '\t');
+      if (p == 0 || (p = strchr (p + 1, '\t')) == 0)
+        continue;
+      p++;
+      if (ninsns == MAX_INSNS)
+        fatal ("too many instructions", 0);
+      in = &insns[ninsns];
+      memset (in, 0, sizeof *in);
+      in->addr = addr;
+      in->func = nfuncs - 1;
+      q = p + strcspn (p, " \t");
+      if (q - p >= (long) sizeof in->name || q == p)
+        continue;
+      memcpy (in->name, p, q - p);
+      in->name[q - p] = 0;
+      q += strspn (q, " \t");
+      strncpy (ops, q, sizeof ops - 1);
+      ops[sizeof ops - 1] = 0;
+      if (strcmp (in->name, ".byte") == 0 || strcmp (in->name, "...") == 0)
+        continue;
+      decode (in, ops);
+      funcs[nfuncs - 1].last = ninsns;
+      ninsns++;
+    }
+}
+
+int
+main (int argc, char *argv[])
+{
+  const struct walk *w;
+  long inflight = 0;
+  long blocking = 0;
+  long entry;
+  long lone;
+  long steady;
+  long total;
+  int rom = 0;
+  int f;
+  int i;
+  int c;
+
+  while ((c = getopt (argc, argv, "rf:b:")) != -1)
+    switch (c)
+      {
+      case 'r':
+        rom = 1;
+        break;
+      case 'f':
+        handler = optarg;
+        break;
+      case 'b':
+        io_base = strtoul (optarg, 0, 0);
+        break;
+      default:
+        fprintf (stderr, "usage: %s [-r] [-f handler] [-b base] "
+                 "< disassembly\n", argv[0]);
+        return 2;
+      }
+
+  read_disassembly (stdin);
+  f = find_func (handler);
+  if (f < 0 || funcs[f].last < funcs[f].first)
+    fatal ("handler not found in the disassembly", 0);
+
+  /* Frame push and vector fetch, then the pseudo-vector jump.  */
+  entry = 14 + (rom ? 0 : 3);
+
+  w = walk (funcs[f].first);
+  if (w->loop_arm)
+    fprintf (stderr, "isrcycles: warning: loop in %s before the TOC4 "
+             "write, counted once\n", handler);
+  if (w->arm < 0)
+    fatal ("the handler never writes TOC4", 0);
+
+  /* A lower priority interrupt which has just been taken delays the
+     handler by its whole length.  */
+  for (i = 0; i < nfuncs; i++)
+    {
+      const struct walk *o;
+      long len;
+
+      if (i == f || !is_handler (funcs[i].name)
+          || funcs[i].last < funcs[i].first)
+        continue;
+      o = walk (funcs[i].first);
+      if (o->loop_arm || o->loop_exit)
+        {
+          fprintf (stderr, "isrcycles: warning: loop in %s, "
+                   "not counted\n", funcs[i].name);
+          continue;
+        }
+      len = entry + max (o->exit, o->arm);
+      fprintf (stderr, "%-28s %5ld (whole interrupt)\n", funcs[i].name, len);
+      blocking = max (blocking, len);
+    }
+
+  /* Otherwise the instruction being executed when the compare matches
+     completes first.  WAI has already stacked the frame.  */
+  for (i = 0; i < ninsns; i++)
+    if (!is_handler (funcs[insns[i].func].name)
+        && strcmp (insns[i].name, "wai") != 0)
+      inflight = max (inflight, insns[i].cycles);
+
+  lone = max (inflight, blocking) + entry + w->arm;
+  fprintf (stderr, "instruction in flight        %5ld\n", inflight);
+  fprintf (stderr, "other interrupt              %5ld\n", blocking);
+  fprintf (stderr, "interrupt entry              %5ld\n", entry);
+  fprintf (stderr, "%-28s %5ld to the TOC4 write\n", handler, w->arm);
+  fprintf (stderr, "compare match to armed       %5ld\n", lone);
+
+  /* Back to back short intervals: each edge must also leave the time
+     to finish the previous interrupt.  */
+  if (w->exit < 0)
+    {
+      fprintf (stderr, "%-28s does not return, "
+               "back to back intervals not checked\n", handler);
+      total = lone;
+    }
+  else
+    {
+      if (w->loop_exit && !w->loop_arm)
+        fprintf (stderr, "isrcycles: warning: loop in %s after the TOC4 "
+                 "write, counted once\n", handler);
+      steady = entry + w->exit;
+      fprintf (stderr, "whole interrupt              %5ld\n", steady);
+      total = max (lone, steady);
+    }
+  fprintf (stderr, "minimum interval             %5ld cycles\n", total);
+  printf ("%ld\n", total);
+  return 0;
+}
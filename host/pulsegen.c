@@ -0,0 +1,616 @@
+/* Pulse Generator pattern generator
+   Copyright (C) 2003 Free Software Foundation, Inc.
+
+This file is free software; you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the
+Free Software Foundation; either version 2, or (at your option) any
+later version.
+
+In addition to the permissions in the GNU General Public License, the
+Free Software Foundation gives you unlimited permission to link the
+compiled version of this file with other programs, and to distribute
+those programs without any restriction coming from the use of this
+file.  (The General Public License restrictions do apply in other
+respects; for example, they cover modification of the file, and
+distribution when not linked into another program.)
+
+This file is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to
+the Free Software Foundation, 59 Temple Place - Suite 330,
+Boston, MA 02111-1307, USA.  */
+
+/* Turns a pattern specification into the `cycle_table' initializer:
+
+     pulsegen [-x crystal] [-p prescaler] [-m min] [-M run] [-l] [-n]
+              [-r] [-d] [file]
+
+   Each line of the specification gives one interval, or two for a
+   frequency, optionally repeated:
+
+     500us              an interval (units: c, ns, us, ms, s)
+     3.3kHz 25%         a period split in high and low intervals
+                        (units: Hz, kHz, MHz; 50% when not given)
+     100us x4           repeated 4 times
+
+   and `#' starts a comment.  Intervals are converted to timer counts
+   for the given crystal (Hz) and prescaler (1, 4, 8 or 16), which
+   default to PULSE_CRYSTAL and PULSE_PRESCALER of pulse.h.  The
+   conversion is done on exact integers and rounded to the nearest
+   count; a period keeps its rounded length whatever its duty cycle.
+   The worst rounding error and the resulting error on the pattern
+   period are reported on the error output.
+
+   An interval below `min' E clock cycles (PULSE_MIN_INTERVAL by
+   default) or beyond the 16-bit counter range is an error, unless -l
+   allows the PULSE_LONG encoding of pulse.h for the latter.  So is a
+   run of intervals below `run' (the whole interrupt, PULSE_RUN_INTERVAL
+   by default, or `min' when only -m is given as the host/isrcycles
+   figure covers both) which delays an interrupt past its compare:
+   each interrupt is only taken once the previous one has returned.  Nothing
+   is written when an error is found, so that a bad pattern stops the
+   build.  With -n plain numbers are written, for host/pulseload or
+   host/pulserle.
+
+   With -r nothing is generated: the resolution, range and rounding
+   errors of the pattern are compared for the four prescalers, to
+   pick the best trade-off.
+
+   With -d the specification is a single frequency (or interval) for
+   the fractional mode of pulse.c (-DPULSE_DDS): the options giving
+   its high and low intervals with 16 bits of fraction are written
+   instead of a table, to be used as PULSE_FLAGS.  The achieved
+   frequency error is reported next to the one of a table, and the
+   peak to peak jitter of the intervals and of the edges.  */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+
+#include "../pulse.h"
+
+#define MAX_SPECS   16384
+#define MAX_ENTRIES 65536
+
+/* Intermediate products need more than 64 bits (GCC extension).  */
+typedef unsigned __int128 wide;
+
+/* One line of the specification.  The interval is `num / den'
+   seconds, or timer counts when `counts' is set.  A period is split
+   in a high part of `duty_num / duty_den' and the rest.  */
+struct spec
+{
+  unsigned long long num;
+  unsigned long long den;
+  unsigned long long duty_num;
+  unsigned long long duty_den;
+  unsigned long repeat;
+  int counts;
+  int line;
+};
+
+static unsigned long crystal = PULSE_CRYSTAL;
+static unsigned long prescaler = PULSE_PRESCALER;
+static unsigned long min_interval = PULSE_MIN_INTERVAL;
+static unsigned long run_interval;
+static int allow_long;
+static int numbers;
+static int report;
+static int dds;
+
+static const char *file_name = "<stdin>";
+static int line_number;
+static int errors;
+static int quiet;
+
+static struct spec specs[MAX_SPECS];
+static unsigned int spec_count;
+
+static unsigned long entries[MAX_ENTRIES];
+static int entry_lines[MAX_ENTRIES];
+static unsigned int count;
+
+/* Rounding statistics of the last conversion.  */
+static double max_error;
+static double exact_total;
+static double rounded_total;
+
+static void
+error (const char *msg, const char *arg)
+{
+  if (!quiet)
+    fprintf (stderr, "%s:%d: %s%s\n", file_name, line_number, msg, arg);
+  errors++;
+}
+
+/* Decimal number with an optional fraction: value = mantissa / scale.  */
+static const char *
+parse_number (const char *p, unsigned long long *mantissa,
+              unsigned long long *scale)
+{
+  int fraction = 0;
+
+  *mantissa = 0;
+  *scale = 1;
+  for (; isdigit ((unsigned char) *p) || (*p == '.' && !fraction); p++)
+    {
+      if (*p == '.')
+        {
+          fraction = 1;
+          if (!isdigit ((unsigned char) p[1]))
+            return 0;
+          continue;
+        }
+      if (*mantissa >= 1000000000ULL || *scale >= 1000000ULL)
+        return 0;
+      *mantissa = *mantissa * 10 + (*p - '0');
+      if (fraction)
+        *scale *= 10;
+    }
+  return p;
+}
+
+static unsigned long long
+round_div (wide num, wide den)
+{
+  return (unsigned long long) ((num + den / 2) / den);
+}
+
+static void
+parse_line (char *line)
+{
+  struct spec *sp;
+  unsigned long long m, s, dm = 50, ds = 1;
+  char unit[8];
+  const char *p;
+  char *hash;
+  int n;
+
+  if ((hash = strchr (line, '#')) != 0)
+    *hash = 0;
+  p = line;
+  while (isspace ((unsigned char) *p))
+    p++;
+  if (*p == 0)
+    return;
+
+  if (spec_count == MAX_SPECS)
+    {
+      error ("too many lines", "");
+      return;
+    }
+  sp = &specs[spec_count];
+  sp->line = line_number;
+  sp->repeat = 1;
+  sp->counts = 0;
+  sp->duty_den = 0;
+
+  p = parse_number (p, &m, &s);
+  if (p == 0 || m == 0)
+    {
+      error ("bad number", "");
+      return;
+    }
+  while (*p == ' ' || *p == '\t')
+    p++;
+  if (sscanf (p, "%7[a-zA-Z]%n", unit, &n) != 1)
+    {
+      error ("missing unit", "");
+      return;
+    }
+  p += n;
+
+  /* Duty cycle and repeat count.  */
+  for (;;)
+    {
+      while (isspace ((unsigned char) *p))
+        p++;
+      if (*p == 'x' || *p == '*')
+        {
+          sp->repeat = strtoul (p + 1, (char **) &p, 10);
+          if (sp->repeat == 0)
+            {
+              error ("bad repeat count", "");
+              return;
+            }
+        }
+      else if (isdigit ((unsigned char) *p))
+        {
+          p = parse_number (p, &dm, &ds);
+          if (p == 0 || *p != '%' || dm == 0 || dm >= 100 * ds)
+            {
+              error ("bad duty cycle", "");
+              return;
+            }
+          p++;
+        }
+      else if (*p == 0)
+        break;
+      else
+        {
+          error ("unexpected text: ", p);
+          return;
+        }
+    }
+
+  sp->num = m;
+  sp->den = s;
+  if (strcmp (unit, "c") == 0)
+    sp->counts = 1;
+  else if (strcmp (unit, "s") == 0)
+    ;
+  else if (strcmp (unit, "ms") == 0)
+    sp->den *= 1000ULL;
+  else if (strcmp (unit, "us") == 0)
+    sp->den *= 1000000ULL;
+  else if (strcmp (unit, "ns") == 0)
+    sp->den *= 1000000000ULL;
+  else if (strcmp (unit, "Hz") == 0 || strcmp (unit, "kHz") == 0
+           || strcmp (unit, "MHz") == 0)
+    {
+      /* Period = 1 / frequency.  */
+      sp->num = s;
+      sp->den = m;
+      if (unit[0] == 'k')
+        sp->den *= 1000;
+      else if (unit[0] == 'M')
+        sp->den *= 1000000;
+      sp->duty_num = dm;
+      sp->duty_den = ds * 100;
+    }
+  else
+    {
+      error ("unknown unit: ", unit);
+      return;
+    }
+  spec_count++;
+}
+
+/* Check one interval and append it `repeat' times.  `exact' is the
+   interval in counts before rounding.  */
+static void
+add_entry (unsigned long long value, double exact, unsigned long repeat)
+{
+  double err = (double) value - exact;
+
+  if (value * prescaler < min_interval)
+    {
+      char buf[64];
+
+      sprintf (buf, "%llu < %lu cycles", value * prescaler, min_interval);
+      error ("interval below the interrupt handler minimum: ", buf);
+      return;
+    }
+  if (value > 0xffff && (!allow_long || value > 0xffffffffULL))
+    {
+      char buf[64];
+
+      sprintf (buf, "%llu counts", value);
+      error ("interval beyond the timer range: ", buf);
+      return;
+    }
+
+  if (err < 0)
+    err = -err;
+  if (err > max_error)
+    max_error = err;
+  exact_total += exact * repeat;
+  rounded_total += (double) value * repeat;
+
+  while (repeat--)
+    {
+      if (count == MAX_ENTRIES)
+        {
+          error ("too many entries", "");
+          return;
+        }
+      entry_lines[count] = line_number;
+      entries[count++] = value;
+    }
+}
+
+/* Back to back intervals.  The interrupt of each edge is delayed by
+   what is left of the previous one after `run' cycles from its own
+   edge, and must still set its compare `min' cycles after it is taken.
+   The pattern loops, so the delay at its end carries over to its
+   start: a second pass goes over it with that delay.  */
+static void
+check_runs (void)
+{
+  unsigned long long delay = 0;
+  unsigned long long cycles;
+  unsigned int pass;
+  unsigned int i;
+  char buf[64];
+
+  for (pass = 0; pass < 2; pass++)
+    for (i = 0; i < count; i++)
+      {
+        cycles = (unsigned long long) entries[i] * prescaler;
+        if (delay + min_interval > cycles)
+          {
+            line_number = entry_lines[i];
+            sprintf (buf, "%llu < %lu + %llu cycles", cycles,
+                     min_interval, delay);
+            error ("interval too short after a run of short ones: ", buf);
+            return;
+          }
+        delay = delay + run_interval > cycles
+          ? delay + run_interval - cycles : 0;
+      }
+}
+
+/* Convert the specification for the current crystal and prescaler:
+   counts = seconds * crystal / (4 * prescaler).  */
+static void
+convert (void)
+{
+  unsigned int i;
+  unsigned long r;
+
+  count = 0;
+  errors = 0;
+  max_error = exact_total = rounded_total = 0;
+  for (i = 0; i < spec_count && errors == 0; i++)
+    {
+      struct spec *sp = &specs[i];
+      wide num = (wide) sp->num * crystal;
+      wide den = (wide) sp->den * 4 * prescaler;
+      unsigned long long period, high;
+
+      line_number = sp->line;
+      if (sp->counts)
+        {
+          num = sp->num;
+          den = sp->den;
+        }
+      if (sp->duty_den == 0)
+        {
+          add_entry (round_div (num, den), (double) num / den, sp->repeat);
+          continue;
+        }
+      period = round_div (num, den);
+      high = round_div (num * sp->duty_num, den * sp->duty_den);
+      for (r = 0; r < sp->repeat && errors == 0; r++)
+        {
+          add_entry (high, (double) num * sp->duty_num
+                     / ((double) den * sp->duty_den), 1);
+          add_entry (period - high, (double) num / den
+                     - (double) num * sp->duty_num
+                     / ((double) den * sp->duty_den), 1);
+        }
+    }
+  if (errors == 0)
+    check_runs ();
+}
+
+/* Rounding summary of the last conversion, in ns and ppm.  */
+static void
+print_errors (void)
+{
+  double count_ns = 4e9 * prescaler / crystal;
+
+  fprintf (stderr, "%u entries, resolution %.1f ns, "
+           "max rounding error %.1f ns, period error %+.1f ppm\n",
+           count, count_ns, max_error * count_ns,
+           exact_total ? 1e6 * (rounded_total - exact_total) / exact_total
+           : 0.0);
+}
+
+/* Compare the prescalers for this pattern.  */
+static void
+print_tradeoffs (void)
+{
+  static const unsigned long prescalers[] = { 1, 4, 8, 16 };
+  unsigned int i;
+
+  quiet = 1;
+  printf ("prescaler  resolution       range  max error  period error\n");
+  for (i = 0; i < 4; i++)
+    {
+      double count_ns;
+
+      prescaler = prescalers[i];
+      count_ns = 4e9 * prescaler / crystal;
+      convert ();
+      printf ("%9lu  %7.1f ns  %7.2f ms", prescaler, count_ns,
+              0xffff * count_ns / 1e6);
+      if (errors)
+        printf ("  (pattern does not fit)\n");
+      else
+        printf ("  %6.1f ns  %+9.1f ppm\n", max_error * count_ns,
+                exact_total
+                ? 1e6 * (rounded_total - exact_total) / exact_total : 0.0);
+    }
+}
+
+/* Fractional intervals of the -DPULSE_DDS mode.  */
+static int
+print_dds (void)
+{
+  struct spec *sp = &specs[0];
+  wide num = (wide) sp->num * crystal * 65536;
+  wide den = (wide) sp->den * 4 * prescaler;
+  double count_ns = 4e9 * prescaler / crystal;
+  unsigned long long high, low, shortest, longest;
+  double exact, achieved, table;
+  char buf[64];
+
+  line_number = sp->line;
+  if (spec_count != 1 || sp->repeat != 1)
+    {
+      error ("-d needs a single frequency or interval", "");
+      return 1;
+    }
+  if (sp->counts)
+    {
+      num = (wide) sp->num * 65536;
+      den = sp->den;
+    }
+
+  /* Exact period and achieved one, in 1/65536 counts.  */
+  if (sp->duty_den)
+    {
+      high = round_div (num * sp->duty_num, den * sp->duty_den);
+      low = round_div (num, den) - high;
+      exact = (double) num / den;
+    }
+  else
+    {
+      high = low = round_div (num, den);
+      exact = 2.0 * num / den;
+    }
+  achieved = (double) high + low;
+
+  shortest = (high < low ? high : low) >> 16;
+  longest = ((high > low ? high : low) + 0xffff) >> 16;
+  if (shortest * prescaler < min_interval)
+    {
+      sprintf (buf, "%llu < %lu cycles", shortest * prescaler, min_interval);
+      error ("interval below the interrupt handler minimum: ", buf);
+      return 1;
+    }
+  if (longest > 0xffff)
+    {
+      sprintf (buf, "%llu counts", longest);
+      error ("interval beyond the timer range: ", buf);
+      return 1;
+    }
+
+  /* The same period as a table of whole counts.  */
+  convert ();
+  table = rounded_total * 65536;
+  if (!sp->duty_den)
+    table *= 2;
+
+  fprintf (stderr, "frequency %.6f Hz, error %+.4f ppm "
+           "(table: %.6f Hz, %+.4f ppm)\n",
+           crystal / (4.0 * prescaler) * 65536 / achieved,
+           1e6 * (exact - achieved) / achieved,
+           crystal / (4.0 * prescaler) * 65536 / table,
+           1e6 * (exact - table) / table);
+  if ((high | low) & 0xffff)
+    fprintf (stderr, "jitter %.1f ns peak to peak on the intervals, "
+             "edges within %.1f ns of their exact place\n",
+             count_ns, count_ns);
+  else
+    fprintf (stderr, "no jitter: the intervals are whole counts\n");
+
+  printf ("-DPULSE_DDS -DPULSE_DDS_HIGH=0x%llx", high);
+  if (low != high)
+    printf (" -DPULSE_DDS_LOW=0x%llx", low);
+  printf ("\n");
+  return 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+  char line[256];
+  unsigned int i;
+  FILE *fp = stdin;
+  int c;
+
+  while ((c = getopt (argc, argv, "x:p:m:M:lnrd")) != -1)
+    switch (c)
+      {
+      case 'x':
+        crystal = strtoul (optarg, 0, 0);
+        break;
+      case 'p':
+        prescaler = strtoul (optarg, 0, 0);
+        if (prescaler != 1 && prescaler != 4 && prescaler != 8
+            && prescaler != 16)
+          {
+            fprintf (stderr, "pulsegen: prescaler must be 1, 4, 8 or 16\n");
+            return 2;
+          }
+        break;
+      case 'm':
+        min_interval = strtoul (optarg, 0, 0);
+        if (run_interval == 0)
+          run_interval = min_interval;
+        break;
+      case 'M':
+        run_interval = strtoul (optarg, 0, 0);
+        break;
+      case 'l':
+        allow_long = 1;
+        break;
+      case 'n':
+        numbers = 1;
+        break;
+      case 'r':
+        report = 1;
+        break;
+      case 'd':
+        dds = 1;
+        break;
+      default:
+        fprintf (stderr, "usage: %s [-x crystal] [-p prescaler] [-m min] "
+                 "[-M run] [-l] [-n] [-r] [-d] [file]\n", argv[0]);
+        return 2;
+      }
+  if (run_interval == 0)
+    run_interval = PULSE_RUN_INTERVAL;
+  if (optind < argc)
+    {
+      file_name = argv[optind];
+      if ((fp = fopen (file_name, "r")) == 0)
+        {
+          perror (file_name);
+          return 2;
+        }
+    }
+  if (crystal == 0)
+    {
+      fprintf (stderr, "pulsegen: bad crystal frequency\n");
+      return 2;
+    }
+
+  while (fgets (line, sizeof line, fp))
+    {
+      line_number++;
+      parse_line (line);
+    }
+  if (errors == 0 && spec_count == 0)
+    {
+      line_number = 0;
+      error ("empty pattern", "");
+    }
+  if (errors)
+    return 1;
+
+  if (report)
+    {
+      print_tradeoffs ();
+      return 0;
+    }
+  if (dds)
+    return print_dds ();
+
+  convert ();
+  if (errors)
+    return 1;
+  print_errors ();
+
+  if (!numbers)
+    printf ("/* Generated by pulsegen from %s, crystal %lu Hz, "
+            "prescaler %lu.  */\n", file_name, crystal, prescaler);
+  for (i = 0; i < count; i++)
+    {
+      if (numbers)
+        printf ("%lu\n", entries[i]);
+      else if (entries[i] > 0xffff)
+        printf ("   PULSE_LONG, %lu, %lu,\t/* line %d */\n",
+                entries[i] >> 16, entries[i] & 0xffff, entry_lines[i]);
+      else
+        printf ("   %lu,\t/* line %d */\n", entries[i], entry_lines[i]);
+    }
+  return 0;
+}
@@ -0,0 +1,109 @@
+/* Pulse Generator pattern upload
+   Copyright (C) 2003 Free Software Foundation, Inc.
+
+This file is free software; you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the
+Free Software Foundation; either version 2, or (at your option) any
+later version.
+
+In addition to the permissions in the GNU General Public License, the
+Free Software Foundation gives you unlimited permission to link the
+compiled version of this file with other programs, and to distribute
+those programs without any restriction coming from the use of this
+file.  (The General Public License restrictions do apply in other
+respects; for example, they cover modification of the file, and
+distribution when not linked into another program.)
+
+This file is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to
+the Free Software Foundation, 59 Temple Place - Suite 330,
+Boston, MA 02111-1307, USA.  */
+
+/* Builds the frame which uploads a new pattern to a board running
+   pulse.c compiled with -DPULSE_LOAD:
+
+     pulseload [file] > /dev/ttyS0
+
+   The pattern is read from `file' (or the standard input) as a list
+   of cycle counts, decimal or 0x prefixed, separated by blanks or new
+   lines; a `#' starts a comment.  The serial line must be setup
+   beforehand (9600 baud, 8N1, raw).  It must be built with the
+   PULSE_FLAGS of the board, for PULSE_LOAD_SIZE of pulse.h: the board
+   rejects a longer pattern.  */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../pulse.h"
+
+#define MAX_ENTRIES PULSE_LOAD_SIZE
+
+int
+main (int argc, char *argv[])
+{
+  static unsigned short pattern[MAX_ENTRIES];
+  unsigned int count = 0;
+  unsigned long value;
+  unsigned char sum;
+  unsigned int i;
+  char word[32];
+  FILE *fp = stdin;
+  int c;
+
+  if (argc > 2)
+    {
+      fprintf (stderr, "usage: %s [file]\n", argv[0]);
+      return 2;
+    }
+  if (argc == 2 && (fp = fopen (argv[1], "r")) == 0)
+    {
+      perror (argv[1]);
+      return 2;
+    }
+
+  while (fscanf (fp, " %31s", word) == 1)
+    {
+      if (word[0] == '#')
+        {
+          while ((c = getc (fp)) != EOF && c != '\n')
+            continue;
+          continue;
+        }
+      value = strtoul (word, 0, 0);
+      if (value > 0xffff)
+        {
+          fprintf (stderr, "%s: entry %u does not fit 16 bits\n",
+                   argv[0], count);
+          return 1;
+        }
+      if (count == MAX_ENTRIES)
+        {
+          fprintf (stderr, "%s: more than %u entries\n",
+                   argv[0], MAX_ENTRIES);
+          return 1;
+        }
+      pattern[count++] = value;
+    }
+  if (count == 0)
+    {
+      fprintf (stderr, "%s: empty pattern\n", argv[0]);
+      return 1;
+    }
+
+  sum = (count >> 8) + count;
+  putchar ('P');
+  putchar (count >> 8);
+  putchar (count);
+  for (i = 0; i < count; i++)
+    {
+      putchar (pattern[i] >> 8);
+      putchar (pattern[i]);
+      sum += (pattern[i] >> 8) + pattern[i];
+    }
+  putchar (sum);
+  return 0;
+}
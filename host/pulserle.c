@@ -0,0 +1,342 @@
+/* Pulse Generator run-length pattern encoder
+   Copyright (C) 2003 Free Software Foundation, Inc.
+
+This file is free software; you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the
+Free Software Foundation; either version 2, or (at your option) any
+later version.
+
+In addition to the permissions in the GNU General Public License, the
+Free Software Foundation gives you unlimited permission to link the
+compiled version of this file with other programs, and to distribute
+those programs without any restriction coming from the use of this
+file.  (The General Public License restrictions do apply in other
+respects; for example, they cover modification of the file, and
+distribution when not linked into another program.)
+
+This file is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to
+the Free Software Foundation, 59 Temple Place - Suite 330,
+Boston, MA 02111-1307, USA.  */
+
+/* Encodes a flat pattern for pulse.c compiled with -DPULSE_RLE:
+
+     pulserle [-d depth] [file] > table.h
+
+   The pattern is read like host/pulseload does (cycle counts separated
+   by blanks, `#' comments).  The encoded table is written as a C
+   initializer using the REPEAT, LOOP and END_LOOP macros of pulse.h.
+   The size of both tables and the decoding cost per edge (average and
+   worst case, with the estimates of pulse.c) are reported on the error
+   output.  The encoding is decoded back and checked against the input
+   before it is written.  */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../pulse.h"
+
+#define MAX_ENTRIES 65536
+#define MAX_WORDS   (3 * MAX_ENTRIES)
+
+/* Longest block searched for a loop.  */
+#define MAX_BLOCK   64
+
+/* Decoding costs in cycles, see pulse_rle_fetch in pulse.c.  */
+#define COST_FLAT     25
+#define COST_RUN      20
+#define COST_VALUE    35
+#define COST_REPEAT   55
+#define COST_LOOP     40
+
+static unsigned short flat[MAX_ENTRIES];
+static unsigned short code[MAX_WORDS];
+static unsigned int code_len;
+static int max_depth = PULSE_RLE_DEPTH;
+
+static void
+emit (unsigned short w)
+{
+  if (code_len == MAX_WORDS)
+    {
+      fprintf (stderr, "pulserle: encoded table too large\n");
+      exit (1);
+    }
+  code[code_len++] = w;
+}
+
+/* Number of times the block of `len' entries at `pos' repeats in a
+   row, not going past `end'.  */
+static unsigned int
+repeats (unsigned int pos, unsigned int len, unsigned int end)
+{
+  unsigned int n = 1;
+
+  while (n < 0xffff && pos + (n + 1) * len <= end
+         && memcmp (&flat[pos], &flat[pos + n * len],
+                    len * sizeof flat[0]) == 0)
+    n++;
+  return n;
+}
+
+static unsigned int encode (unsigned int pos, unsigned int end, int depth);
+
+/* Size of the encoding of [pos, end) without keeping it.  */
+static unsigned int
+encoded_size (unsigned int pos, unsigned int end, int depth)
+{
+  unsigned int save = code_len;
+  unsigned int size;
+
+  encode (pos, end, depth);
+  size = code_len - save;
+  code_len = save;
+  return size;
+}
+
+/* Greedy encoding: at each position take the run or loop which saves
+   the most words, if any.  */
+static unsigned int
+encode (unsigned int pos, unsigned int end, int depth)
+{
+  unsigned int start = code_len;
+
+  while (pos < end)
+    {
+      unsigned int best_len = 0, best_n = 0;
+      long best_gain = 0;
+      unsigned int len;
+
+      for (len = 1; len <= MAX_BLOCK && pos + 2 * len <= end; len++)
+        {
+          unsigned int n = repeats (pos, len, end);
+          long gain;
+
+          if (n < 2)
+            continue;
+          if (len == 1)
+            gain = (long) n - 3;
+          else if (depth < max_depth)
+            gain = (long) (n * len)
+              - (3 + encoded_size (pos, pos + len, depth + 1));
+          else
+            continue;
+          if (gain > best_gain)
+            {
+              best_gain = gain;
+              best_len = len;
+              best_n = n;
+            }
+        }
+
+      if (best_len == 1)
+        {
+          emit (PULSE_REPEAT);
+          emit (best_n);
+          emit (flat[pos]);
+        }
+      else if (best_len > 1)
+        {
+          emit (PULSE_LOOP);
+          emit (best_n);
+          encode (pos, pos + best_len, depth + 1);
+          emit (PULSE_END_LOOP);
+        }
+      else
+        {
+          emit (flat[pos]);
+          best_len = 1;
+          best_n = 1;
+        }
+      pos += best_len * best_n;
+    }
+  return code_len - start;
+}
+
+/* Decoder mirroring pulse_rle_fetch, with its cycle cost.  */
+struct decoder
+{
+  unsigned int pc;
+  unsigned short value;
+  unsigned short count;
+  int depth;
+  unsigned int body[PULSE_RLE_DEPTH + 1];
+  unsigned short loops[PULSE_RLE_DEPTH + 1];
+};
+
+static unsigned short
+fetch (struct decoder *d, unsigned int *cost)
+{
+  unsigned short w;
+
+  if (d->count)
+    {
+      d->count--;
+      *cost = COST_RUN;
+      return d->value;
+    }
+  *cost = 0;
+  for (;;)
+    {
+      if (d->pc >= code_len)
+        d->pc = 0;
+      w = code[d->pc++];
+      if (w >= PULSE_CODE_LIMIT)
+        {
+          *cost += COST_VALUE;
+          return w;
+        }
+      switch (w)
+        {
+        case PULSE_REPEAT:
+          d->count = code[d->pc] - 1;
+          d->value = code[d->pc + 1];
+          d->pc += 2;
+          *cost += COST_REPEAT;
+          return d->value;
+
+        case PULSE_LOOP:
+          d->loops[d->depth] = code[d->pc++];
+          d->body[d->depth] = d->pc;
+          d->depth++;
+          break;
+
+        case PULSE_END_LOOP:
+          if (--d->loops[d->depth - 1])
+            d->pc = d->body[d->depth - 1];
+          else
+            d->depth--;
+          break;
+
+        default:
+          fprintf (stderr, "pulserle: bad code %u\n", w);
+          exit (1);
+        }
+      *cost += COST_LOOP;
+    }
+}
+
+static unsigned int
+read_pattern (FILE *fp)
+{
+  unsigned int count = 0;
+  unsigned long value;
+  char word[32];
+  int c;
+
+  while (fscanf (fp, " %31s", word) == 1)
+    {
+      if (word[0] == '#')
+        {
+          while ((c = getc (fp)) != EOF && c != '\n')
+            continue;
+          continue;
+        }
+      value = strtoul (word, 0, 0);
+      if (value < PULSE_CODE_LIMIT || value > 0xffff)
+        {
+          fprintf (stderr, "pulserle: entry %u (%lu) out of range\n",
+                   count, value);
+          exit (1);
+        }
+      if (count == MAX_ENTRIES)
+        {
+          fprintf (stderr, "pulserle: more than %u entries\n", MAX_ENTRIES);
+          exit (1);
+        }
+      flat[count++] = value;
+    }
+  return count;
+}
+
+int
+main (int argc, char *argv[])
+{
+  struct decoder d;
+  unsigned int count;
+  unsigned int i, cost, worst = 0;
+  unsigned long total = 0;
+  FILE *fp = stdin;
+  int c;
+
+  while ((c = getopt (argc, argv, "d:")) != -1)
+    switch (c)
+      {
+      case 'd':
+        max_depth = atoi (optarg);
+        if (max_depth < 0 || max_depth > PULSE_RLE_DEPTH)
+          {
+            fprintf (stderr, "pulserle: depth must be 0 to %d\n",
+                     PULSE_RLE_DEPTH);
+            return 2;
+          }
+        break;
+      default:
+        fprintf (stderr, "usage: %s [-d depth] [file]\n", argv[0]);
+        return 2;
+      }
+  if (optind < argc && (fp = fopen (argv[optind], "r")) == 0)
+    {
+      perror (argv[optind]);
+      return 2;
+    }
+
+  count = read_pattern (fp);
+  if (count == 0)
+    {
+      fprintf (stderr, "pulserle: empty pattern\n");
+      return 1;
+    }
+  encode (0, count, 0);
+
+  /* Check the encoding over two periods so that the wrap is covered.  */
+  memset (&d, 0, sizeof d);
+  for (i = 0; i < 2 * count; i++)
+    {
+      if (fetch (&d, &cost) != flat[i % count])
+        {
+          fprintf (stderr, "pulserle: encoding error at entry %u\n", i);
+          return 1;
+        }
+      if (cost > worst)
+        worst = cost;
+      if (i >= count)
+        total += cost;
+    }
+
+  for (i = 0; i < code_len; i++)
+    {
+      switch (code[i])
+        {
+        case PULSE_REPEAT:
+          printf ("   REPEAT (%u, %u)", code[i + 1], code[i + 2]);
+          i += 2;
+          break;
+        case PULSE_LOOP:
+          printf ("   LOOP (%u)", code[i + 1]);
+          i++;
+          break;
+        case PULSE_END_LOOP:
+          printf ("   END_LOOP");
+          break;
+        default:
+          printf ("   %u", code[i]);
+          break;
+        }
+      printf ("%s\n", i + 1 < code_len ? "," : "");
+    }
+
+  fprintf (stderr, "flat:    %u entries, %u bytes, %u cycles/edge\n",
+           count, 2 * count, COST_FLAT);
+  fprintf (stderr, "encoded: %u words, %u bytes (%.1f%%), "
+           "%.1f cycles/edge average, %u worst\n",
+           code_len, 2 * code_len, 100.0 * code_len / count,
+           (double) total / count, worst);
+  return 0;
+}
@@ -0,0 +1,400 @@
+/* Pulse Generator Linux real-time backend
+
+This file is free software; you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the
+Free Software Foundation; either version 2, or (at your option) any
+later version.
+
+In addition to the permissions in the GNU General Public License, the
+Free Software Foundation gives you unlimited permission to link the
+compiled version of this file with other programs, and to distribute
+those programs without any restriction coming from the use of this
+file.  (The General Public License restrictions do apply in other
+respects; for example, they cover modification of the file, and
+distribution when not linked into another program.)
+
+This file is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to
+the Free Software Foundation, 59 Temple Place - Suite 330,
+Boston, MA 02111-1307, USA.  */
+
+/* Runs the unmodified pulse.c interrupt handlers in real time on a
+   Linux host, to try a pattern before programming a board:
+
+     pulsert [-n edges] [-b] [-r] [-o file]
+
+   The free running counter is CLOCK_MONOTONIC scaled to the timer
+   rate given by PULSE_CRYSTAL and the prescaler.  The program sleeps
+   until the earliest compare with clock_nanosleep (TIMER_ABSTIME),
+   or spins on the clock with -b, then applies the TCTL1 action of the
+   compare and calls its handler as the HC11 would.  The handlers only
+   see the <sys/ports.h> interface, as on the board, so this runs the
+   same drift-free scheduling: each compare is computed from the
+   previous one, never from the time the handler ran.
+
+   With -o each edge is written to `file', which stands for the GPIO:
+   edge number, nanoseconds since the start, pin, level and the
+   jitter.  -r asks for SCHED_FIFO and locked memory (this needs the
+   privilege to do so).
+
+   The jitter of an edge is the difference between the interval from
+   the previous edge of its pin and the interval the table asked for.
+   The achieved edge rate and the jitter histogram are printed on the
+   error output.  A late wake-up only moves that edge, but a handler
+   which runs after its next compare was due sets it in the past and,
+   as on the board, that edge comes one counter turn late: it lands
+   in the last bucket.  The wake-up latency of clock_nanosleep (tens
+   of microseconds on a stock kernel) must stay well below the
+   shortest interval; -b and -r are there for short ones.  */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <errno.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "hc11sim.h"
+
+#define main pulse_main
+#include "../pulse.c"
+#undef main
+
+#if defined (PULSE_TRIGGER) || defined (PULSE_VERIFY)
+# error "pulsert has no capture input, run -DPULSE_TRIGGER or" \
+        " -DPULSE_VERIFY on pulsesim"
+#endif
+
+/* Intermediate products need more than 64 bits (GCC extension).  */
+typedef unsigned __int128 wide;
+
+#define OC_FLAG(N)   (0x80 >> ((N) - 1))
+#define OC_PIN(N)    (8 - (N))
+#define OC_VECTOR(N) (TIMER_OUTPUT1_VECTOR - ((N) - 1))
+
+/* Jitter histogram: bucket N counts the edges with a jitter below
+   2^N microseconds, the last one the others.  */
+#define RT_BUCKETS 16
+
+unsigned char _io_ports[0x40];
+interrupt_t hc11_vectors[MAX_VECTORS];
+unsigned char hc11_locked;
+
+/* Compare N matches when the counter, counted from the start without
+   wrapping, reaches `match'.  `due' is when the program meant it to
+   match: successive compare values are relative to each other, even
+   when one is set too late.  */
+static struct
+{
+  unsigned long long match;
+  unsigned long long due;
+  unsigned short toc;
+  unsigned char active;
+} rt_oc[6];
+
+static struct timespec rt_start;
+static FILE *rt_out;
+static unsigned long rt_edges;
+static unsigned long rt_hist[RT_BUCKETS];
+static unsigned long long rt_err_sum;
+static unsigned long long rt_err_max;
+static unsigned long long rt_last_due;
+
+/* Time of the last edge of each port A pin and of its compare.  */
+static unsigned long long rt_pin_time[8];
+static unsigned long long rt_pin_due[8];
+static unsigned char rt_pin_seen;
+
+/* E clock cycles per timer count, from the TMSK2 prescaler bits.  */
+static unsigned long
+rt_prescale (void)
+{
+  static const unsigned char rates[] = { 1, 4, 8, 16 };
+
+  return rates[_io_ports[M6811_TMSK2] & (M6811_PR1 | M6811_PR0)];
+}
+
+static unsigned long long
+rt_now_ns (void)
+{
+  struct timespec t;
+
+  clock_gettime (CLOCK_MONOTONIC, &t);
+  return (t.tv_sec - rt_start.tv_sec) * 1000000000ULL
+    + t.tv_nsec - rt_start.tv_nsec;
+}
+
+static unsigned long long
+rt_counts_to_ns (unsigned long long counts)
+{
+  return (wide) counts * 4000000000ULL * rt_prescale () / PULSE_CRYSTAL;
+}
+
+static unsigned long long
+rt_counts (void)
+{
+  return (wide) rt_now_ns () * PULSE_CRYSTAL
+    / (4000000000ULL * rt_prescale ());
+}
+
+unsigned short
+get_timer_counter (void)
+{
+  return (unsigned short) rt_counts ();
+}
+
+/* The flags are not kept here: each compare calls its handler when it
+   matches, so the acknowledges only need somewhere to go.  */
+int
+hc11_tflg1_access (void)
+{
+  return HC11_TFLG1;
+}
+
+/* As on the HC11, a compare equal to the counter or already in the
+   past only matches after the counter wraps.  */
+static void
+rt_set_compare (int n, unsigned short value)
+{
+  unsigned long long now = rt_counts ();
+  unsigned short wait = value - (unsigned short) now;
+
+  rt_oc[n].match = now + (wait ? wait : 0x10000);
+  wait = value - rt_oc[n].toc;
+  if (rt_oc[n].active)
+    rt_oc[n].due += wait ? wait : 0x10000;
+  else
+    rt_oc[n].due = rt_oc[n].match;
+  rt_oc[n].toc = value;
+  rt_oc[n].active = 1;
+}
+
+void
+set_output_compare_2 (unsigned short value)
+{
+  rt_set_compare (2, value);
+}
+
+void
+set_output_compare_3 (unsigned short value)
+{
+  rt_set_compare (3, value);
+}
+
+void
+set_output_compare_4 (unsigned short value)
+{
+  rt_set_compare (4, value);
+}
+
+void
+set_output_compare_5 (unsigned short value)
+{
+  rt_set_compare (5, value);
+}
+
+/* There is no serial line: nothing is received and replies are
+   dropped.  */
+unsigned char
+hc11_sci_pending (void)
+{
+  return 0;
+}
+
+unsigned char
+hc11_sci_recv (void)
+{
+  return 0;
+}
+
+void
+hc11_sci_send (unsigned char c)
+{
+}
+
+/* Apply the TCTL1 action of compare N at `now', for a compare due
+   at `due' (nanoseconds).  */
+static void
+rt_action (int n, unsigned long long now, unsigned long long due)
+{
+  unsigned long long err;
+  int mode;
+  int pin;
+  int i;
+
+  mode = (_io_ports[M6811_TCTL1] >> ((5 - n) * 2)) & 3;
+  if (n < 2 || mode == 0)
+    return;
+
+  pin = OC_PIN (n);
+  if (rt_pin_seen & (1 << pin))
+    err = now - rt_pin_time[pin] - (due - rt_pin_due[pin]);
+  else
+    err = now - due;
+  if ((long long) err < 0)
+    err = -err;
+  rt_pin_seen |= 1 << pin;
+  rt_pin_time[pin] = now;
+  rt_pin_due[pin] = due;
+
+  if (mode == 1)
+    _io_ports[M6811_PORTA] ^= 1 << pin;
+  else if (mode == 3)
+    _io_ports[M6811_PORTA] |= 1 << pin;
+  else
+    _io_ports[M6811_PORTA] &= ~(1 << pin);
+
+  for (i = 0; i < RT_BUCKETS - 1 && err >= (1000ULL << i); i++)
+    continue;
+  rt_hist[i]++;
+  rt_last_due = due;
+  rt_err_sum += err;
+  if (err > rt_err_max)
+    rt_err_max = err;
+
+  if (rt_out)
+    fprintf (rt_out, "%8lu %12llu PA%d %d %8llu\n", rt_edges, now, pin,
+             (_io_ports[M6811_PORTA] >> pin) & 1, err);
+  rt_edges++;
+}
+
+/* Forced compares (CFORC) written by a handler.  */
+static void
+rt_force (void)
+{
+  unsigned char v = _io_ports[M6811_CFORC];
+  unsigned long long now;
+  int n;
+
+  if (v == 0)
+    return;
+  _io_ports[M6811_CFORC] = 0;
+  now = rt_now_ns ();
+  for (n = 2; n <= 5; n++)
+    if (v & OC_FLAG (n))
+      rt_action (n, now, now);
+}
+
+/* Wait for the earliest compare and handle it.  */
+static int
+rt_step (int busy)
+{
+  unsigned long long due;
+  unsigned long long now;
+  struct timespec t;
+  int n = 0;
+  int i;
+
+  for (i = 1; i <= 5; i++)
+    if (rt_oc[i].active && (n == 0 || rt_oc[i].match < rt_oc[n].match))
+      n = i;
+  if (n == 0)
+    return 0;
+
+  due = rt_counts_to_ns (rt_oc[n].match);
+  if (busy)
+    {
+      while ((now = rt_now_ns ()) < due)
+        continue;
+    }
+  else
+    {
+      t.tv_sec = rt_start.tv_sec + (rt_start.tv_nsec + due) / 1000000000ULL;
+      t.tv_nsec = (rt_start.tv_nsec + due) % 1000000000ULL;
+      while (clock_nanosleep (CLOCK_MONOTONIC, TIMER_ABSTIME, &t, 0)
+             == EINTR)
+        continue;
+      now = rt_now_ns ();
+    }
+
+  rt_action (n, now, rt_counts_to_ns (rt_oc[n].due));
+  rt_oc[n].match += 0x10000;
+  if ((_io_ports[M6811_TMSK1] & OC_FLAG (n)) && hc11_vectors[OC_VECTOR (n)])
+    {
+      hc11_vectors[OC_VECTOR (n)] ();
+      rt_force ();
+    }
+  pulse_idle ();
+  return 1;
+}
+
+static void
+rt_realtime (void)
+{
+  struct sched_param param;
+
+  param.sched_priority = sched_get_priority_max (SCHED_FIFO);
+  if (sched_setscheduler (0, SCHED_FIFO, &param) != 0)
+    perror ("sched_setscheduler");
+  if (mlockall (MCL_CURRENT | MCL_FUTURE) != 0)
+    perror ("mlockall");
+}
+
+int
+main (int argc, char *argv[])
+{
+  unsigned long count = 2 * TABLE_SIZE (cycle_table);
+  const char *out = 0;
+  int busy = 0;
+  unsigned long long secs;
+  int c;
+  int i;
+
+  while ((c = getopt (argc, argv, "n:bro:")) != -1)
+    switch (c)
+      {
+      case 'n':
+        count = strtoul (optarg, 0, 0);
+        break;
+      case 'b':
+        busy = 1;
+        break;
+      case 'r':
+        rt_realtime ();
+        break;
+      case 'o':
+        out = optarg;
+        break;
+      default:
+        fprintf (stderr, "usage: %s [-n edges] [-b] [-r] [-o file]\n",
+                 argv[0]);
+        return 2;
+      }
+
+  if (out && (rt_out = fopen (out, "w")) == 0)
+    {
+      perror (out);
+      return 2;
+    }
+
+  clock_gettime (CLOCK_MONOTONIC, &rt_start);
+#if PULSE_PRESCALER != 1
+  __premain ();
+#endif
+  pulse_init ();
+
+  while (rt_edges < count && rt_step (busy))
+    continue;
+
+  secs = rt_now_ns ();
+  fprintf (stderr, "%lu edges in %.3f s, %.0f edges/s (table %.0f)",
+           rt_edges, secs / 1e9, secs ? rt_edges / (secs / 1e9) : 0.0,
+           rt_last_due ? rt_edges / (rt_last_due / 1e9) : 0.0);
+  if (rt_edges)
+    fprintf (stderr, ", jitter mean %.1f us, max %.1f us",
+             rt_err_sum / 1e3 / rt_edges, rt_err_max / 1e3);
+  fprintf (stderr, "\njitter histogram (us edges):\n");
+  for (i = 0; i < RT_BUCKETS; i++)
+    if (rt_hist[i])
+      fprintf (stderr, "%s%6u %lu\n", i == RT_BUCKETS - 1 ? ">=" : " <",
+               i == RT_BUCKETS - 1 ? 1u << (i - 1) : 1u << i, rt_hist[i]);
+  if (rt_out)
+    fclose (rt_out);
+  return 0;
+}
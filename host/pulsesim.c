@@ -0,0 +1,714 @@
+/* Pulse Generator host model
+   Copyright (C) 2003 Free Software Foundation, Inc.
+
+This file is free software; you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the
+Free Software Foundation; either version 2, or (at your option) any
+later version.
+
+In addition to the permissions in the GNU General Public License, the
+Free Software Foundation gives you unlimited permission to link the
+compiled version of this file with other programs, and to distribute
+those programs without any restriction coming from the use of this
+file.  (The General Public License restrictions do apply in other
+respects; for example, they cover modification of the file, and
+distribution when not linked into another program.)
+
+This file is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to
+the Free Software Foundation, 59 Temple Place - Suite 330,
+Boston, MA 02111-1307, USA.  */
+
+/* Runs the unmodified pulse.c interrupt handler against the HC11
+   timer model and prints the edge timeline:
+
+     pulsesim [-q] [-n edges] [-l latency] [-s seed] [-d dispatch]
+              [-u frame | -S trace] [-t cycle] [-T cycle[,period,count]]
+              [-v file] [-c config]
+
+   Each line gives the edge number, the E clock cycle of the match,
+   the pin and its new level, the measured interval and the interval
+   the handler programmed (in E clock cycles, whatever the timer
+   prescaler).  An interval which differs from the
+   programmed one is flagged `late': the handler was not fast enough
+   and the compare only matched after the counter wrapped.
+
+   With -q only the summary is printed, which is how the model is
+   used to benchmark a handler or table change.
+
+   With -v the compare outputs PA3 to PA6 are also written to `file'
+   as a Value Change Dump (GTKWave and most waveform viewers read it),
+   in picoseconds.  The dump is written as the edges are produced, so
+   its length is not limited by memory.
+
+   With -c the run is a benchmark (see bench.sh and `make bench'):
+   the results are written on the standard output as `config,metric,
+   entry,value' CSV lines for the given configuration name, instead
+   of the timeline.  The metrics are the number of late edges, the
+   worst jitter (measured minus programmed interval, on any pin), the
+   percentiles of the compare interrupt latency (from the match to the
+   handler body) and the edge rate of the model.  For a flat table the
+   PA4 intervals are also checked against `cycle_table' and the worst
+   error of each entry is given.
+
+   With -u, the bytes of the `frame' file (a pattern upload frame made
+   by host/pulseload, or serial commands) are sent on the SCI at 9600
+   baud from cycle 100000 or the one given with -t.  The board replies
+   are printed on the error output.
+
+   With -S, for a board built with -DPULSE_STREAM, the model plays the
+   part of host/pulsestream: the intervals of the `trace' file (same
+   format as for host/pulseload) are streamed at 9600 baud from cycle
+   100000 or the one given with -t, following the credits the board
+   gives back.  The number of underruns is printed with the summary.
+
+   With -T, for a board built with -DPULSE_TRIGGER, trigger pulses of
+   TRIGGER_WIDTH cycles are applied to the input capture pin from the
+   given cycle, `count' of them `period' cycles apart.  The summary
+   gives the range of the delay from each trigger taken to the next
+   PA4 edge, and what the board measured.
+
+   Built with -DPULSE_VERIFY, PA4 is wired to PA0/IC3 as the self test
+   needs and its result is printed when the board sends it (after
+   PULSE_VERIFY_EDGES intervals) and with the summary.  A large -l
+   makes some compares late, which the test must report.
+
+   Built with PULSE_FLAGS=-DPULSE_LATENCY, the latency histogram kept
+   by the handler is printed after the summary.  With -DPULSE_TX_BUFFER
+   the replies are sent by the SCI interrupt, whose handler is run
+   like the timer ones.  */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hc11sim.h"
+
+#define main pulse_main
+#include "../pulse.c"
+#undef main
+
+/* SCI byte time at 9600 baud, 8N1.  */
+#define SCI_CYCLES_PER_BYTE (PULSE_CRYSTAL / 4 / 960)
+
+static int quiet;
+static unsigned char sci_reply[7];
+static int sci_reply_len;
+static unsigned long late;
+static unsigned long worst;
+static FILE *vcd;
+static unsigned long long vcd_time;
+
+/* Benchmark state (-c).  The PA4 edge N > 0 ends the interval of the
+   entry N - 1 (modulo the table size) of a flat table.  */
+#if !defined (PULSE_RLE) && !defined (PULSE_EXTENDED) \
+    && !defined (PULSE_SWEEP) && !defined (PULSE_DDS) \
+    && !defined (PULSE_RANDOM)
+# ifdef PULSE_FAST
+#  define BENCH_ENTRIES (TABLE_SIZE (cycle_table) - 1)
+# else
+#  define BENCH_ENTRIES TABLE_SIZE (cycle_table)
+# endif
+static unsigned long bench_error[BENCH_ENTRIES];
+static unsigned long bench_pa4;
+#endif
+#define BENCH_LATENCY 1024
+static const char *bench;
+static unsigned long bench_jitter;
+static unsigned long bench_latency[BENCH_LATENCY + 1];
+static unsigned long bench_entries;
+
+static void
+bench_edge (const struct hc11_edge *edge)
+{
+  unsigned long d;
+#ifdef BENCH_ENTRIES
+  unsigned long expect;
+  unsigned long i;
+#endif
+
+  d = edge->delta > edge->expect ? edge->delta - edge->expect
+    : edge->expect - edge->delta;
+  if (d > bench_jitter)
+    bench_jitter = d;
+
+#ifdef BENCH_ENTRIES
+  if (edge->pin != 4)
+    return;
+  if (bench_pa4++ == 0)
+    return;
+  i = (bench_pa4 - 2) % BENCH_ENTRIES;
+  expect = (unsigned long) cycle_table[i] * PULSE_PRESCALER;
+  d = edge->delta > expect ? edge->delta - expect : expect - edge->delta;
+  if (d > bench_error[i])
+    bench_error[i] = d;
+#endif
+}
+
+static void
+bench_entry (int n, unsigned long latency)
+{
+  bench_latency[latency < BENCH_LATENCY ? latency : BENCH_LATENCY]++;
+  bench_entries++;
+}
+
+/* Smallest latency above `percent' % of the interrupts.  */
+static unsigned long
+bench_percentile (unsigned percent)
+{
+  unsigned long want = (bench_entries * percent + 99) / 100;
+  unsigned long sum = 0;
+  unsigned long i;
+
+  for (i = 0; i < BENCH_LATENCY; i++)
+    {
+      sum += bench_latency[i];
+      if (sum >= want && sum > 0)
+        break;
+    }
+  return i;
+}
+
+static void
+bench_report (double secs)
+{
+  static const unsigned char percents[] = { 50, 90, 99, 100 };
+  unsigned long i;
+
+  printf ("%s,late,,%lu\n", bench, late);
+  printf ("%s,jitter_max,,%lu\n", bench, bench_jitter);
+  for (i = 0; i < sizeof percents; i++)
+    printf ("%s,latency_p%u,,%lu\n", bench, percents[i],
+            bench_percentile (percents[i]));
+#ifdef BENCH_ENTRIES
+  for (i = 0; i < BENCH_ENTRIES; i++)
+    printf ("%s,entry_error,%lu,%lu\n", bench, i, bench_error[i]);
+#endif
+  printf ("%s,edges_per_s,,%.0f\n", bench, secs > 0 ? hc11_edges / secs : 0);
+}
+
+/* VCD identifier of port A pin N (PA3 to PA6).  */
+#define VCD_ID(N) ('!' + (N) - 3)
+
+static void
+vcd_start (FILE *fp)
+{
+  int pin;
+
+  fprintf (fp, "$comment pulse.c on the HC11 timer model, crystal %lu Hz, "
+           "prescaler %d $end\n", (unsigned long) PULSE_CRYSTAL,
+           PULSE_PRESCALER);
+  fprintf (fp, "$timescale 1 ps $end\n");
+  fprintf (fp, "$scope module hc11 $end\n");
+  for (pin = 6; pin >= 3; pin--)
+    fprintf (fp, "$var wire 1 %c PA%d $end\n", VCD_ID (pin), pin);
+  fprintf (fp, "$upscope $end\n$enddefinitions $end\n");
+  fprintf (fp, "#0\n$dumpvars\n");
+  for (pin = 6; pin >= 3; pin--)
+    fprintf (fp, "0%c\n", VCD_ID (pin));
+  fprintf (fp, "$end\n");
+}
+
+static void
+vcd_edge (FILE *fp, const struct hc11_edge *edge)
+{
+  /* One E clock cycle is 4 crystal periods.  */
+  unsigned long long t = (unsigned long long)
+    ((unsigned __int128) edge->cycle * 4000000000000ULL / PULSE_CRYSTAL);
+
+  if (edge->pin < 3 || edge->pin > 6)
+    return;
+  if (t != vcd_time)
+    {
+      fprintf (fp, "#%llu\n", t);
+      vcd_time = t;
+    }
+  fprintf (fp, "%d%c\n", edge->level, VCD_ID (edge->pin));
+}
+
+#ifdef PULSE_DDS
+/* Frequency and jitter of the fractional square wave on PA4.  */
+static unsigned long long dds_first;
+static unsigned long long dds_last;
+static unsigned long dds_edges;
+static unsigned long dds_min[2] = { ~0UL, ~0UL };
+static unsigned long dds_max[2];
+
+static void
+dds_edge (const struct hc11_edge *edge)
+{
+  if (edge->pin != 4)
+    return;
+  if (dds_edges++ == 0)
+    dds_first = edge->cycle;
+  else
+    {
+      /* High and low intervals apart.  */
+      int i = dds_edges % 2;
+
+      if (edge->delta < dds_min[i])
+        dds_min[i] = edge->delta;
+      if (edge->delta > dds_max[i])
+        dds_max[i] = edge->delta;
+    }
+  if ((dds_edges - 1) % 2 == 0)
+    dds_last = edge->cycle;
+}
+
+/* The exact frequency is the one of the PULSE_DDS_HIGH and
+   PULSE_DDS_LOW intervals; the measured one spans whole periods.  */
+static void
+dds_report (void)
+{
+  double e_clock = PULSE_CRYSTAL / 4.0;
+  double exact = e_clock * 65536.0
+    / ((double) PULSE_DDS_HIGH + PULSE_DDS_LOW) / PULSE_PRESCALER;
+  unsigned long periods = (dds_edges - 1) / 2;
+  unsigned long long span;
+  unsigned long jitter;
+  double hz;
+
+  if (periods == 0)
+    return;
+  span = dds_last - dds_first;
+  hz = e_clock * periods / span;
+  jitter = dds_max[0] - dds_min[0];
+  if (dds_max[1] - dds_min[1] > jitter)
+    jitter = dds_max[1] - dds_min[1];
+  fprintf (stderr, "dds: %.6f Hz over %lu periods, %+.3f ppm from "
+           "%.6f Hz, interval jitter %lu cycles peak to peak\n",
+           hz, periods, 1e6 * (hz - exact) / exact, exact, jitter);
+}
+#endif
+
+#ifdef PULSE_TRIGGER
+/* Trigger pulses (-T): the pin goes high at the even entries of
+   `trigger_input' and low at the odd ones.  */
+# define TRIGGER_WIDTH 100
+static unsigned long long *trigger_input;
+static unsigned long trigger_inputs;
+static unsigned short trigger_seen;
+static unsigned long trigger_min = ~0UL;
+static unsigned long trigger_max;
+
+/* The first PA4 edge after the board took a trigger: the trigger is
+   the edge whose capture the board read, which TICx may no longer
+   hold (the trailing edge of the pulse with -DPULSE_TRIGGER_EDGE=3).  */
+static void
+trigger_edge (const struct hc11_edge *edge)
+{
+  unsigned long d;
+
+  if (edge->pin != 4 || trigger_seen == trigger_count)
+    return;
+  trigger_seen = trigger_count;
+  d = (unsigned long) (edge->cycle - hc11_capture_cycle (PULSE_TRIGGER_IC));
+  if (d < trigger_min)
+    trigger_min = d;
+  if (d > trigger_max)
+    trigger_max = d;
+}
+
+static void
+trigger_report (void)
+{
+  if (trigger_count == 0)
+    {
+      fprintf (stderr, "no trigger taken\n");
+      return;
+    }
+  fprintf (stderr, "%u triggers taken, first edge %lu to %lu cycles "
+           "after the trigger; board: slack %u counts, %u late\n",
+           trigger_count, trigger_min, trigger_max, trigger_slack,
+           trigger_late);
+}
+#endif
+
+static void
+print_edge (const struct hc11_edge *edge)
+{
+  int bad = edge->delta != edge->expect;
+
+  if (bad)
+    {
+      late++;
+      if (edge->delta > edge->expect && edge->delta - edge->expect > worst)
+        worst = edge->delta - edge->expect;
+    }
+  if (vcd)
+    vcd_edge (vcd, edge);
+  if (bench)
+    bench_edge (edge);
+#ifdef PULSE_DDS
+  dds_edge (edge);
+#endif
+#ifdef PULSE_TRIGGER
+  trigger_edge (edge);
+#endif
+  if (!quiet)
+    printf ("%8lu %12llu PA%d %d %6lu %6lu%s\n",
+            edge->index, edge->cycle, edge->pin, edge->level,
+            edge->delta, edge->expect, bad ? " late" : "");
+}
+
+#ifdef PULSE_STREAM
+/* Host side of the stream (-S).  A new frame is only queued once the
+   board has read the previous one, which keeps the line busy.  */
+static FILE *stream_fp;
+static unsigned char stream_frame[4 + 2 * 255];
+static unsigned int stream_credit;
+static int stream_ready;
+static int stream_started;
+static int stream_eof;
+static unsigned long stream_sent;
+
+static int
+stream_read (unsigned short *value)
+{
+  char word[32];
+  int c;
+
+  while (fscanf (stream_fp, " %31s", word) == 1)
+    {
+      if (word[0] == '#')
+        {
+          while ((c = getc (stream_fp)) != EOF && c != '\n')
+            continue;
+          continue;
+        }
+      *value = strtoul (word, 0, 0);
+      return 1;
+    }
+  return 0;
+}
+
+static void
+stream_feed (void)
+{
+  unsigned long len = 0;
+  unsigned short v;
+  unsigned int n = 0;
+
+  if (stream_fp == 0 || !stream_ready || hc11_sci_input_left ())
+    return;
+  if (stream_credit > 0 && !stream_eof)
+    {
+      while (n < stream_credit && n < 255)
+        {
+          if (!stream_read (&v))
+            {
+              stream_eof = 1;
+              break;
+            }
+          stream_frame[2 + 2 * n] = v >> 8;
+          stream_frame[3 + 2 * n] = v;
+          n++;
+        }
+      if (n > 0)
+        {
+          stream_frame[0] = 'D';
+          stream_frame[1] = n;
+          len = 2 + 2 * n;
+          stream_credit -= n;
+          stream_sent += n;
+        }
+    }
+
+  /* Start once the first credit is used up (or the trace is).  */
+  if (!stream_started && (stream_credit == 0 || stream_eof))
+    {
+      stream_frame[len++] = 'G';
+      stream_started = 1;
+    }
+  if (stream_eof && stream_fp)
+    {
+      stream_frame[len++] = 'F';
+      fclose (stream_fp);
+      stream_fp = 0;
+    }
+  if (len)
+    hc11_sci_input (stream_frame, len, hc11_now, SCI_CYCLES_PER_BYTE);
+}
+
+static void
+stream_idle (void)
+{
+  stream_feed ();
+  pulse_idle ();
+}
+#endif
+
+static void
+print_reply (unsigned char c)
+{
+  sci_reply[sci_reply_len++] = c;
+  if ((sci_reply[0] == 'S' || sci_reply[0] == 'O' || sci_reply[0] == 'M'
+       || sci_reply[0] == 'U')
+      && sci_reply_len < 3)
+    return;
+  if (sci_reply[0] == 'C' && sci_reply_len < 2)
+    return;
+  if ((sci_reply[0] == 'T' || sci_reply[0] == 'V') && sci_reply_len < 7)
+    return;
+  if (sci_reply[0] == 'C')
+    {
+#ifdef PULSE_STREAM
+      stream_credit += sci_reply[1];
+      stream_ready = 1;
+#endif
+    }
+  else if (sci_reply[0] == 'T')
+    fprintf (stderr, "triggers: %u, slack %u, late %u\n",
+             (sci_reply[1] << 8) | sci_reply[2],
+             (sci_reply[3] << 8) | sci_reply[4],
+             (sci_reply[5] << 8) | sci_reply[6]);
+  else if (sci_reply[0] == 'V')
+    fprintf (stderr, "verify: %u intervals, %u errors, max error %u\n",
+             (sci_reply[1] << 8) | sci_reply[2],
+             (sci_reply[3] << 8) | sci_reply[4],
+             (sci_reply[5] << 8) | sci_reply[6]);
+  else if (sci_reply[0] == 'U')
+    fprintf (stderr, "underruns: %u\n", (sci_reply[1] << 8) | sci_reply[2]);
+  else if (sci_reply[0] == 'S')
+    fprintf (stderr, "new pattern: first edge %u cycles after upload\n",
+             (sci_reply[1] << 8) | sci_reply[2]);
+  else if (sci_reply[0] == 'O')
+    fprintf (stderr, "overruns: %u\n", (sci_reply[1] << 8) | sci_reply[2]);
+  else if (sci_reply[0] == 'M')
+    fprintf (stderr, "missed edges: %u\n",
+             (sci_reply[1] << 8) | sci_reply[2]);
+  else if (c == 'K' || c == 'E' || c == 'B')
+    fprintf (stderr, "upload: %c\n", c);
+  else if (c != '\r')
+    fputc (c, stderr);
+  sci_reply_len = 0;
+}
+
+static unsigned char *
+read_file (const char *name, unsigned long *len)
+{
+  static unsigned char buf[65536];
+  FILE *fp = fopen (name, "rb");
+
+  if (fp == 0)
+    {
+      perror (name);
+      exit (2);
+    }
+  *len = fread (buf, 1, sizeof buf, fp);
+  fclose (fp);
+  return buf;
+}
+
+int
+main (int argc, char *argv[])
+{
+  unsigned long count = 2 * TABLE_SIZE (cycle_table);
+  unsigned long seed = 1;
+  long latency = -1;
+  long dispatch = -1;
+  const char *upload = 0;
+  const char *trace = 0;
+  const char *triggers = 0;
+  unsigned long long upload_start = 100000;
+  unsigned char *frame;
+  unsigned long frame_len;
+  clock_t start;
+  double secs;
+  int c;
+
+  while ((c = getopt (argc, argv, "qn:l:s:d:u:S:t:T:v:c:")) != -1)
+    switch (c)
+      {
+      case 'q':
+        quiet = 1;
+        break;
+      case 'n':
+        count = strtoul (optarg, 0, 0);
+        break;
+      case 'l':
+        latency = strtol (optarg, 0, 0);
+        break;
+      case 's':
+        seed = strtoul (optarg, 0, 0);
+        break;
+      case 'd':
+        dispatch = strtol (optarg, 0, 0);
+        break;
+      case 'u':
+        upload = optarg;
+        break;
+      case 'S':
+        trace = optarg;
+        break;
+      case 't':
+        upload_start = strtoull (optarg, 0, 0);
+        break;
+      case 'T':
+        triggers = optarg;
+        break;
+      case 'c':
+        bench = optarg;
+        quiet = 1;
+        break;
+      case 'v':
+        vcd = fopen (optarg, "w");
+        if (vcd == 0)
+          {
+            perror (optarg);
+            return 2;
+          }
+        break;
+      default:
+        fprintf (stderr, "usage: %s [-q] [-n edges] [-l latency] "
+                 "[-s seed] [-d dispatch] [-u frame | -S trace] [-t cycle] "
+                 "[-T cycle[,period,count]] [-v file] [-c config]\n",
+                 argv[0]);
+        return 2;
+      }
+
+  hc11_reset (seed);
+  if (latency >= 0)
+    hc11_cost.latency = latency;
+  if (dispatch >= 0)
+    hc11_cost.dispatch = dispatch;
+#ifdef PULSE_WAI
+  hc11_wai = 1;
+#endif
+#ifdef PULSE_FAST
+  /* Estimated from the page zero handler, see pulse.c.  */
+  hc11_cost.prologue = 8;
+  hc11_cost.arm = 24;
+  hc11_cost.epilogue = 40;
+#endif
+  hc11_edge_hook = print_edge;
+  hc11_entry_hook = bench_entry;
+  hc11_idle_hook = pulse_idle;
+  hc11_sci_hook = print_reply;
+  hc11_sci_output (SCI_CYCLES_PER_BYTE);
+  if (upload)
+    {
+      frame = read_file (upload, &frame_len);
+      hc11_sci_input (frame, frame_len, upload_start, SCI_CYCLES_PER_BYTE);
+    }
+  if (trace)
+    {
+#ifdef PULSE_STREAM
+      stream_fp = fopen (trace, "r");
+      if (stream_fp == 0)
+        {
+          perror (trace);
+          return 2;
+        }
+      hc11_sci_input ((const unsigned char *) "R", 1, upload_start,
+                      SCI_CYCLES_PER_BYTE);
+      hc11_idle_hook = stream_idle;
+#else
+      fprintf (stderr, "%s: -S needs a -DPULSE_STREAM build\n", argv[0]);
+      return 2;
+#endif
+    }
+
+  if (triggers)
+    {
+#ifdef PULSE_TRIGGER
+      unsigned long long first;
+      unsigned long long period = 0;
+      unsigned long n = 1;
+      unsigned long i;
+      char *end;
+
+      first = strtoull (triggers, &end, 0);
+      if (*end == ',')
+        {
+          period = strtoull (end + 1, &end, 0);
+          if (*end == ',')
+            n = strtoul (end + 1, &end, 0);
+        }
+      if (*end || n == 0 || (n > 1 && period <= TRIGGER_WIDTH))
+        {
+          fprintf (stderr, "%s: bad trigger list `%s'\n", argv[0], triggers);
+          return 2;
+        }
+      trigger_input = malloc (2 * n * sizeof *trigger_input);
+      if (trigger_input == 0)
+        {
+          perror (argv[0]);
+          return 2;
+        }
+      for (i = 0; i < n; i++)
+        {
+          trigger_input[2 * i] = first + i * period;
+          trigger_input[2 * i + 1] = first + i * period + TRIGGER_WIDTH;
+        }
+      trigger_inputs = 2 * n;
+      hc11_capture_input (PULSE_TRIGGER_IC, trigger_input, trigger_inputs);
+#else
+      fprintf (stderr, "%s: -T needs a -DPULSE_TRIGGER build\n", argv[0]);
+      return 2;
+#endif
+    }
+
+#ifdef PULSE_VERIFY
+  hc11_loopback (4, 3);
+#endif
+
+#if PULSE_PRESCALER != 1
+  __premain ();
+#endif
+  pulse_init ();
+
+  if (vcd)
+    vcd_start (vcd);
+
+  start = clock ();
+  hc11_run (count);
+  if (vcd)
+    fclose (vcd);
+  secs = (double) (clock () - start) / CLOCKS_PER_SEC;
+
+  if (bench)
+    {
+      bench_report (secs);
+      return late != 0;
+    }
+  fprintf (stderr, "%lu edges, %llu cycles, %lu late (worst +%lu)",
+           hc11_edges, hc11_now, late, worst);
+  if (secs > 0)
+    fprintf (stderr, ", %.2f Medges/s", hc11_edges / secs / 1e6);
+  fprintf (stderr, "\n");
+#ifdef PULSE_OVERRUN
+  fprintf (stderr, "%u overruns\n", overrun_count);
+#endif
+#ifdef PULSE_DDS
+  dds_report ();
+#endif
+#ifdef PULSE_TRIGGER
+  trigger_report ();
+#endif
+#ifdef PULSE_VERIFY
+  fprintf (stderr, "verify: %u intervals, %u errors, max error %u counts%s\n",
+           verify_edges, verify_errors, verify_max,
+           verify_done ? "" : " (still running)");
+#endif
+#ifdef PULSE_STREAM
+  if (trace)
+    fprintf (stderr, "%lu entries streamed, %u underruns\n",
+             stream_sent, stream_underrun);
+#endif
+#ifdef PULSE_LATENCY
+  fprintf (stderr, "latency histogram (cycles count):\n");
+  hc11_sci_hook = print_reply;
+  pulse_latency_dump ();
+#ifdef PULSE_TX_BUFFER
+  while (tx_tail != tx_head)
+    sci_interrupt ();
+#endif
+#endif
+  return late != 0;
+}
@@ -0,0 +1,252 @@
+/* Pulse Generator stream sender
+   Copyright (C) 2003 Free Software Foundation, Inc.
+
+This file is free software; you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the
+Free Software Foundation; either version 2, or (at your option) any
+later version.
+
+In addition to the permissions in the GNU General Public License, the
+Free Software Foundation gives you unlimited permission to link the
+compiled version of this file with other programs, and to distribute
+those programs without any restriction coming from the use of this
+file.  (The General Public License restrictions do apply in other
+respects; for example, they cover modification of the file, and
+distribution when not linked into another program.)
+
+This file is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to
+the Free Software Foundation, 59 Temple Place - Suite 330,
+Boston, MA 02111-1307, USA.  */
+
+/* Streams a trace to a board running pulse.c compiled with
+   -DPULSE_STREAM, following the credit the board gives back:
+
+     pulsestream [-d device] [file]
+
+   The trace is read from `file' (or the standard input) as it is
+   sent, in the format of host/pulseload: cycle counts, decimal or
+   0x prefixed, separated by blanks or new lines, `#' starting a
+   comment.  Its length is not limited.  The serial line (/dev/ttyS0
+   by default) is set to 9600 baud, 8N1, raw.
+
+   Each entry takes 2 bytes on the line, about 2.1 ms at 9600 baud,
+   so the line keeps up with about 470 edges per second on average;
+   the FIFO of the board absorbs the faster parts of the trace.  The
+   number of underruns (edges the FIFO was empty for) is printed at
+   the end, 0 when the link kept up with the whole trace.  */
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+static int tty;
+static unsigned int credit;
+static int have_underrun;
+static unsigned int underrun;
+static unsigned long dropped;
+
+static void
+send_bytes (const unsigned char *buf, unsigned long len)
+{
+  ssize_t n;
+
+  while (len > 0)
+    {
+      n = write (tty, buf, len);
+      if (n < 0)
+        {
+          perror ("write");
+          exit (1);
+        }
+      buf += n;
+      len -= n;
+    }
+}
+
+/* Read the replies of the board until at least one byte came.  'C'
+   gives credit back, 'U' is the underrun count and 'E' a dropped
+   entry; the others (main loop status) are skipped.  */
+static void
+read_replies (void)
+{
+  static unsigned char reply[3];
+  static int len;
+  static int want;
+  unsigned char buf[64];
+  ssize_t n;
+  ssize_t i;
+
+  n = read (tty, buf, sizeof buf);
+  if (n <= 0)
+    {
+      perror ("read");
+      exit (1);
+    }
+  for (i = 0; i < n; i++)
+    {
+      if (len == 0)
+        {
+          if (buf[i] == 'C')
+            want = 2;
+          else if (buf[i] == 'U' || buf[i] == 'O' || buf[i] == 'M'
+                   || buf[i] == 'S')
+            want = 3;
+          else
+            {
+              if (buf[i] == 'E')
+                dropped++;
+              continue;
+            }
+        }
+      reply[len++] = buf[i];
+      if (len < want)
+        continue;
+      if (reply[0] == 'C')
+        credit += reply[1];
+      else if (reply[0] == 'U')
+        {
+          underrun = (reply[1] << 8) | reply[2];
+          have_underrun = 1;
+        }
+      len = 0;
+    }
+}
+
+static int
+read_entry (FILE *fp, unsigned short *value)
+{
+  unsigned long v;
+  char word[32];
+  int c;
+
+  while (fscanf (fp, " %31s", word) == 1)
+    {
+      if (word[0] == '#')
+        {
+          while ((c = getc (fp)) != EOF && c != '\n')
+            continue;
+          continue;
+        }
+      v = strtoul (word, 0, 0);
+      if (v > 0xffff)
+        {
+          fprintf (stderr, "pulsestream: %s does not fit 16 bits\n", word);
+          exit (1);
+        }
+      *value = v;
+      return 1;
+    }
+  return 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+  static unsigned char frame[2 + 2 * 255];
+  const char *device = "/dev/ttyS0";
+  unsigned long sent = 0;
+  unsigned short v;
+  struct termios t;
+  FILE *fp = stdin;
+  int started = 0;
+  int eof = 0;
+  unsigned int n;
+  int c;
+
+  while ((c = getopt (argc, argv, "d:")) != -1)
+    switch (c)
+      {
+      case 'd':
+        device = optarg;
+        break;
+      default:
+        fprintf (stderr, "usage: %s [-d device] [file]\n", argv[0]);
+        return 2;
+      }
+  if (optind < argc - 1)
+    {
+      fprintf (stderr, "usage: %s [-d device] [file]\n", argv[0]);
+      return 2;
+    }
+  if (optind == argc - 1 && (fp = fopen (argv[optind], "r")) == 0)
+    {
+      perror (argv[optind]);
+      return 2;
+    }
+
+  tty = open (device, O_RDWR | O_NOCTTY);
+  if (tty < 0 || tcgetattr (tty, &t) < 0)
+    {
+      perror (device);
+      return 2;
+    }
+  cfmakeraw (&t);
+  cfsetispeed (&t, B9600);
+  cfsetospeed (&t, B9600);
+  t.c_cflag |= CLOCAL | CREAD;
+  t.c_cc[VMIN] = 1;
+  t.c_cc[VTIME] = 0;
+  if (tcsetattr (tty, TCSANOW, &t) < 0)
+    {
+      perror (device);
+      return 2;
+    }
+  tcflush (tty, TCIOFLUSH);
+
+  /* Empty the stream; the reply gives the size of the FIFO.  */
+  send_bytes ((const unsigned char *) "R", 1);
+  while (credit == 0)
+    read_replies ();
+
+  while (!eof)
+    {
+      while (credit == 0)
+        read_replies ();
+
+      for (n = 0; n < credit && n < 255; n++)
+        {
+          if (!read_entry (fp, &v))
+            {
+              eof = 1;
+              break;
+            }
+          frame[2 + 2 * n] = v >> 8;
+          frame[3 + 2 * n] = v;
+        }
+      if (n > 0)
+        {
+          frame[0] = 'D';
+          frame[1] = n;
+          send_bytes (frame, 2 + 2 * n);
+          credit -= n;
+          sent += n;
+        }
+
+      /* The initial credit fills the FIFO before the board starts.  */
+      if (!started && (credit == 0 || eof))
+        {
+          send_bytes ((const unsigned char *) "G", 1);
+          started = 1;
+        }
+    }
+
+  /* No underrun can happen once the board has the end of the stream,
+     so the count is final.  */
+  send_bytes ((const unsigned char *) "FU", 2);
+  while (!have_underrun)
+    read_replies ();
+
+  fprintf (stderr, "%lu entries sent, %u underruns", sent, underrun);
+  if (dropped)
+    fprintf (stderr, ", %lu dropped", dropped);
+  fprintf (stderr, "\n");
+  close (tty);
+  return underrun != 0 || dropped != 0;
+}
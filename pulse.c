@@ -77,9 +77,22 @@ N  Interrupt     Cycle Taken         Latency   Delta between interrupts
  8 OUT4                  516               4       999 (499.5 us)
 </pre>
 
+    On a board, build with -DPULSE_LATENCY (PULSE_FLAGS) to have the
+    handler measure its own latency: the `L' serial command dumps the
+    histogram and `Z' clears it.
+
     If you connect an oscilloscope on PA4 you should see the pulses
     with the timing indicated in `cycle_table'.
 
+    The host/ directory builds this file natively against a model of
+    the HC11 timer (no toolchain or board needed).  `host/pulsesim'
+    replays `cycle_table' through the real interrupt handler, charges
+    the interrupt entry/exit cycles and prints the edge timeline,
+    flagging the intervals the handler was too slow to program.
+    `host/pulsert' runs the same handlers in real time on Linux, with
+    the counter taken from the system clock, and reports the jitter
+    of the edges.
+
   @htmlonly
   Source file: <a href="pulse_8c-source.html">pulse.c</a>
   @endhtmlonly
@@ -90,18 +103,114 @@ N  Interrupt     Cycle Taken         Latency   Delta between interrupts
 #include <sys/interrupts.h>
 #include <sys/sio.h>
 #include <sys/locks.h>
+#include "pulse.h"
 
 void output_compare_interrupt (void) __attribute__((interrupt));
+#ifdef PULSE_MULTI
+void output_compare_2_interrupt (void) __attribute__((interrupt));
+void output_compare_3_interrupt (void) __attribute__((interrupt));
+void output_compare_5_interrupt (void) __attribute__((interrupt));
+#endif
+#if defined (PULSE_TX_BUFFER) || defined (PULSE_STREAM)
+void sci_interrupt (void) __attribute__((interrupt));
+#endif
+#if defined (PULSE_TRIGGER) || defined (PULSE_TRIGGER_REARM)
+void input_capture_interrupt (void) __attribute__((interrupt));
+#endif
+#ifdef PULSE_VERIFY
+void verify_timeout_interrupt (void) __attribute__((interrupt));
+#endif
+
+#if PULSE_PRESCALER == 1
+# define PULSE_PR_BITS 0
+#elif PULSE_PRESCALER == 4
+# define PULSE_PR_BITS M6811_PR0
+#elif PULSE_PRESCALER == 8
+# define PULSE_PR_BITS M6811_PR1
+#elif PULSE_PRESCALER == 16
+# define PULSE_PR_BITS (M6811_PR1 | M6811_PR0)
+#else
+# error "PULSE_PRESCALER must be 1, 4, 8 or 16"
+#endif
 
-#define US_TO_CYCLE(N) ((N) * 2)
+/* Microseconds to timer counts, rounded to the nearest count.  This
+   is computed by the compiler on 64 bits; host/pulsegen reports the
+   rounding error of a pattern for a given crystal and prescaler.  */
+#define US_TO_CYCLE(N) \
+   ((unsigned long) (((unsigned long long) (N) * PULSE_CRYSTAL \
+                      + 2000000ULL * PULSE_PRESCALER) \
+                     / (4000000ULL * PULSE_PRESCALER)))
+
+/* With -DPULSE_EXTENDED a table entry may also be an interval longer
+   than one turn of the free running counter (32.7 ms).  It is encoded
+   as the PULSE_LONG marker followed by the high and low words of the
+   32-bit cycle count; US_TO_LONG produces the three entries.  It is
+   meant for intervals of 65536 cycles or more: a shorter one only
+   costs two more entries than a plain interval, as which it is
+   played.  */
+#define US_TO_LONG(N) \
+   PULSE_LONG, \
+   (unsigned short) (US_TO_CYCLE ((unsigned long) (N)) >> 16), \
+   (unsigned short) US_TO_CYCLE ((unsigned long) (N))
 
 /* The cycle table defines the sequence of pulses to generate.
    Each value indicates the number of cycles to wait before inverting
    the output pin.  The US_TO_CYCLE macro makes the translation so
-   that values can be expressed in microseconds (assuming QZ at 8Mhz).
+   that values can be expressed in microseconds (for PULSE_CRYSTAL
+   and PULSE_PRESCALER, 8 MHz and 1 by default).
+
+   Note: A value below about 100 cycles will produce a 32ms pulse
+   because we are not that fast to update the next output compare
+   value.  The exact limit of a build comes from its code: the
+   Makefile runs host/isrcycles on the disassembly of pulse.elf and
+   writes the worst case, from the compare match to the next compare
+   armed, in pulse.min.
+   Build with -DPULSE_BURST to produce such intervals (down to about
+   60 cycles) from within the interrupt handler, see below.
+
+   With -DPULSE_RLE the table is run-length encoded (see pulse.h and
+   host/pulserle which encodes long flat patterns).
+
+   With -DPULSE_PATTERN the table comes from pattern.h, which the
+   Makefile generates from a specification with host/pulsegen (see
+   `make PATTERN=file').  The generator checks every interval against
+   the counter range and against pulse.min, or PULSE_MIN_INTERVAL
+   before the first build.
 
-   Note: A value below 100 cycles will produce a 32ms pulse because
-   we are not that fast to update the next output compare value.  */
+   With -DPULSE_FAST the table ends with the PULSE_FAST_END marker,
+   see the handler.
+
+   With -DPULSE_STREAM the table is played until the host streams its
+   own intervals over the SCI (host/pulsestream), see
+   pulse_stream_byte.  With -DPULSE_SWEEP, -DPULSE_DDS or
+   -DPULSE_RANDOM it is not used, the handler computes the intervals
+   of a sweep, of a fractional square wave or random ones, see
+   pulse_sweep_step, pulse_dds_step and pulse_random_step.  */
+#ifdef PULSE_FAST
+# define PULSE_FAST_END 0
+#endif
+
+#ifdef PULSE_PATTERN
+static const unsigned short cycle_table[] = {
+#include "pattern.h"
+#ifdef PULSE_FAST
+   PULSE_FAST_END
+#endif
+};
+#elif defined (PULSE_RLE)
+static const unsigned short cycle_table[] = {
+   REPEAT (3, US_TO_CYCLE (500)),
+   US_TO_CYCLE (1000),
+   US_TO_CYCLE (1000),
+   US_TO_CYCLE (5000),
+   US_TO_CYCLE (100),
+   US_TO_CYCLE (500),
+   US_TO_CYCLE (5000),
+   US_TO_CYCLE (1000),
+   US_TO_CYCLE (100),
+   US_TO_CYCLE (100)
+};
+#else
 static const unsigned short cycle_table[] = {
    US_TO_CYCLE (500),
    US_TO_CYCLE (500),
@@ -115,10 +224,318 @@ static const unsigned short cycle_table[] = {
    US_TO_CYCLE (1000),
    US_TO_CYCLE (100),
    US_TO_CYCLE (100)
+#ifdef PULSE_EXTENDED
+   , US_TO_LONG (1500000)
+#endif
+#ifdef PULSE_FAST
+   , PULSE_FAST_END
+#endif
 };
+#endif
 
 #define TABLE_SIZE(T) ((sizeof T / sizeof T[0]))
 
+#ifdef PULSE_MULTI
+/* With -DPULSE_MULTI, OC2, OC3 and OC5 produce their own pulse trains
+   on PA6, PA5 and PA3, next to the `cycle_table' one on PA4.  Their
+   period, 1.7 ms, divides the 15.3 ms of `cycle_table' and with the
+   start offsets of pulse_init their edges fall between 300 and 1300 us
+   into each period, away from the 100 us entries of PA4 (see the
+   minimum intervals at struct pulse_channel).  */
+static const unsigned short oc2_table[] = {
+   US_TO_CYCLE (400),
+   US_TO_CYCLE (1300)
+};
+
+static const unsigned short oc3_table[] = {
+   US_TO_CYCLE (600),
+   US_TO_CYCLE (1100)
+};
+
+static const unsigned short oc5_table[] = {
+   US_TO_CYCLE (400),
+   US_TO_CYCLE (1300)
+};
+#endif
+
+/* Intervals below this limit (in timer counts) are chained in burst
+   mode instead of being left to the next interrupt.  So are intervals
+   below PULSE_BURST_RUN, the whole interrupt, which would delay the
+   next interrupt and add up over a run.  */
+#ifndef PULSE_BURST_LIMIT
+# define PULSE_BURST_LIMIT \
+   ((PULSE_MIN_INTERVAL + PULSE_PRESCALER - 1) / PULSE_PRESCALER)
+#endif
+#ifndef PULSE_BURST_RUN
+# define PULSE_BURST_RUN \
+   ((PULSE_RUN_INTERVAL + PULSE_PRESCALER - 1) / PULSE_PRESCALER)
+#endif
+
+/* With -DPULSE_LATENCY the handler keeps a histogram of its entry
+   latency in PULSE_LATENCY_BUCKETS buckets of 2^PULSE_LATENCY_SHIFT
+   timer counts, see pulse_latency_record.  */
+#ifndef PULSE_LATENCY_SHIFT
+# define PULSE_LATENCY_SHIFT 2
+#endif
+#ifndef PULSE_LATENCY_BUCKETS
+# define PULSE_LATENCY_BUCKETS 32
+#endif
+
+/* With -DPULSE_OVERRUN the handler checks that the compare it is about
+   to set is still PULSE_OVERRUN_GUARD timer counts ahead of TCNT, which
+   covers the cycles from the check to the compare write.  See
+   pulse_overrun for what happens when it is not.  */
+#if defined (PULSE_OVERRUN_FORCE) && !defined (PULSE_OVERRUN)
+# define PULSE_OVERRUN
+#endif
+#ifndef PULSE_OVERRUN_GUARD
+# define PULSE_OVERRUN_GUARD ((32 + PULSE_PRESCALER - 1) / PULSE_PRESCALER)
+#endif
+
+/* With -DPULSE_STREAM the intervals are sent by the host over the SCI
+   into a FIFO of PULSE_STREAM_SIZE entries (a power of 2, up to 128),
+   see pulse_stream_byte.  The board gives the host credit for
+   PULSE_STREAM_CREDIT more entries at a time.  The replies must not
+   hold up the reception, so this uses the transmit buffer.  */
+#ifndef PULSE_STREAM_SIZE
+# define PULSE_STREAM_SIZE 64
+#endif
+#ifndef PULSE_STREAM_CREDIT
+# define PULSE_STREAM_CREDIT (PULSE_STREAM_SIZE / 4)
+#endif
+#if defined (PULSE_STREAM) && !defined (PULSE_TX_BUFFER)
+# define PULSE_TX_BUFFER
+#endif
+
+/* With -DPULSE_SWEEP the intervals are not read from a table: they
+   sweep from PULSE_SWEEP_FROM to PULSE_SWEEP_TO timer counts and start
+   again, see pulse_sweep_step.  The sweep is linear and takes about
+   PULSE_SWEEP_STEPS edges, or with -DPULSE_SWEEP_EXP it is
+   exponential, each interval being 2^-PULSE_SWEEP_SHIFT longer (or
+   shorter) than the previous one.  */
+#ifndef PULSE_SWEEP_FROM
+# define PULSE_SWEEP_FROM 1000
+#endif
+#ifndef PULSE_SWEEP_TO
+# define PULSE_SWEEP_TO 200
+#endif
+#ifndef PULSE_SWEEP_STEPS
+# define PULSE_SWEEP_STEPS 4000
+#endif
+#ifndef PULSE_SWEEP_SHIFT
+# define PULSE_SWEEP_SHIFT 10
+#endif
+#define PULSE_SWEEP_STEP \
+   ((PULSE_SWEEP_TO - PULSE_SWEEP_FROM) * 65536LL / PULSE_SWEEP_STEPS)
+#if defined (PULSE_SWEEP_EXP) && !defined (PULSE_SWEEP)
+# define PULSE_SWEEP
+#endif
+
+/* With -DPULSE_DDS the handler produces a square wave whose high and
+   low intervals, PULSE_DDS_HIGH and PULSE_DDS_LOW, are timer counts
+   with 16 bits of fraction, see pulse_dds_step.  `host/pulsegen -d'
+   computes them for a frequency and duty cycle (and prints these
+   options); by default both are the half period of PULSE_DDS_HZ, and
+   without PULSE_DDS_LOW the low interval is the high one.  They are
+   checked by the preprocessor, hence no cast in the default.  */
+#ifndef PULSE_DDS_HZ
+# define PULSE_DDS_HZ 3300
+#endif
+#ifndef PULSE_DDS_HIGH
+# define PULSE_DDS_HIGH \
+   ((PULSE_CRYSTAL * 8192ULL + PULSE_PRESCALER * PULSE_DDS_HZ / 2) \
+    / (PULSE_PRESCALER * PULSE_DDS_HZ))
+#endif
+#ifndef PULSE_DDS_LOW
+# define PULSE_DDS_LOW PULSE_DDS_HIGH
+# define PULSE_DDS_SQUARE
+#endif
+
+/* With -DPULSE_RANDOM the intervals are pseudo-random, between
+   PULSE_RANDOM_MIN and PULSE_RANDOM_MAX timer counts, from a generator
+   started with PULSE_RANDOM_SEED (not 0), see pulse_random_step.  */
+#ifndef PULSE_RANDOM_MIN
+# define PULSE_RANDOM_MIN 200
+#endif
+#ifndef PULSE_RANDOM_MAX
+# define PULSE_RANDOM_MAX 2000
+#endif
+#ifndef PULSE_RANDOM_SEED
+# define PULSE_RANDOM_SEED 1
+#endif
+
+/* With -DPULSE_TRIGGER the pattern waits for an edge on the input
+   capture PULSE_TRIGGER_IC (1 to 3, on PA2 to PA0) and its first edge
+   comes PULSE_TRIGGER_DELAY timer counts after the captured one, see
+   input_capture_interrupt.  PULSE_TRIGGER_EDGE selects the rising (1),
+   falling (2) or both (3) edges.  With -DPULSE_TRIGGER_REARM each
+   trigger plays the table once and the next one is then awaited.  */
+#if defined (PULSE_TRIGGER_REARM) && !defined (PULSE_TRIGGER)
+# define PULSE_TRIGGER
+#endif
+#ifndef PULSE_TRIGGER_IC
+# define PULSE_TRIGGER_IC 1
+#endif
+#ifndef PULSE_TRIGGER_EDGE
+# define PULSE_TRIGGER_EDGE 1
+#endif
+#ifndef PULSE_TRIGGER_DELAY
+# define PULSE_TRIGGER_DELAY 300
+#endif
+
+/* With -DPULSE_VERIFY PA4 must be wired to PA0/IC3: every edge is
+   captured and its interval checked against `cycle_table', see
+   pulse_verify_edge.  An interval more than PULSE_VERIFY_TOLERANCE
+   timer counts off is an error.  The check stops after
+   PULSE_VERIFY_EDGES intervals (0 for never) and the result is then
+   sent once.  An edge which has not come PULSE_VERIFY_MARGIN counts
+   after its time is reported missing.  */
+#ifndef PULSE_VERIFY_TOLERANCE
+# define PULSE_VERIFY_TOLERANCE 0
+#endif
+#ifndef PULSE_VERIFY_EDGES
+# define PULSE_VERIFY_EDGES 256
+#endif
+#ifndef PULSE_VERIFY_MARGIN
+# define PULSE_VERIFY_MARGIN ((2048 + PULSE_PRESCALER - 1) / PULSE_PRESCALER)
+#endif
+
+#if defined (PULSE_LOAD) || defined (PULSE_LATENCY) \
+    || defined (PULSE_OVERRUN) || defined (PULSE_STREAM) \
+    || defined (PULSE_TRIGGER) || defined (PULSE_VERIFY)
+# define PULSE_COMMANDS
+#endif
+
+/* With -DPULSE_TX_BUFFER the main loop output goes through a ring
+   buffer of PULSE_TX_SIZE bytes (a power of 2 from 2 to 256, for the
+   8-bit indexes) drained by the SCI interrupt, see pulse_send.  */
+#ifndef PULSE_TX_SIZE
+# define PULSE_TX_SIZE 64
+#endif
+
+/* With -DPULSE_WAI the main loop waits for the edges with the WAI
+   instruction instead of polling, see main.  */
+#if defined (PULSE_WAI) && !defined (wai)
+# define wai() __asm__ __volatile__ ("wai")
+#endif
+
+#if defined (PULSE_BURST) && defined (PULSE_EXTENDED)
+# error "PULSE_BURST would take the PULSE_LONG marker for a short interval"
+#endif
+#if defined (PULSE_RLE) && (defined (PULSE_BURST) || defined (PULSE_EXTENDED))
+# error "PULSE_RLE tables can't be read by PULSE_BURST or PULSE_EXTENDED"
+#endif
+#if defined (PULSE_FAST) \
+    && (defined (PULSE_BURST) || defined (PULSE_EXTENDED) \
+        || defined (PULSE_RLE) || defined (PULSE_LOAD) \
+        || defined (PULSE_OVERRUN) || defined (PULSE_LATENCY))
+# error "PULSE_FAST has its own handler which only plays a flat table"
+#endif
+#if defined (PULSE_WAI) && defined (PULSE_LOAD)
+# error "PULSE_WAI would lose the upload bytes which come between two edges"
+#endif
+#if defined (PULSE_OVERRUN) && defined (PULSE_EXTENDED)
+# error "PULSE_OVERRUN would skip over the PULSE_LONG entries"
+#endif
+#if defined (PULSE_STREAM) \
+    && (defined (PULSE_BURST) || defined (PULSE_EXTENDED) \
+        || defined (PULSE_RLE) || defined (PULSE_LOAD) \
+        || defined (PULSE_OVERRUN) || defined (PULSE_FAST))
+# error "PULSE_STREAM only plays flat intervals from its FIFO"
+#endif
+#if defined (PULSE_WAI) && defined (PULSE_STREAM)
+# error "PULSE_WAI would lose the stream bytes which come between two edges"
+#endif
+#if defined (PULSE_SWEEP) \
+    && (defined (PULSE_BURST) || defined (PULSE_EXTENDED) \
+        || defined (PULSE_RLE) || defined (PULSE_LOAD) \
+        || defined (PULSE_OVERRUN) || defined (PULSE_FAST) \
+        || defined (PULSE_STREAM))
+# error "PULSE_SWEEP computes its intervals, it does not read a table"
+#endif
+#if defined (PULSE_DDS) \
+    && (defined (PULSE_BURST) || defined (PULSE_EXTENDED) \
+        || defined (PULSE_RLE) || defined (PULSE_LOAD) \
+        || defined (PULSE_OVERRUN) || defined (PULSE_FAST) \
+        || defined (PULSE_STREAM) || defined (PULSE_SWEEP))
+# error "PULSE_DDS computes its intervals, it does not read a table"
+#endif
+#if defined (PULSE_RANDOM) \
+    && (defined (PULSE_BURST) || defined (PULSE_EXTENDED) \
+        || defined (PULSE_RLE) || defined (PULSE_LOAD) \
+        || defined (PULSE_OVERRUN) || defined (PULSE_FAST) \
+        || defined (PULSE_STREAM) || defined (PULSE_SWEEP) \
+        || defined (PULSE_DDS))
+# error "PULSE_RANDOM computes its intervals, it does not read a table"
+#endif
+#if defined (PULSE_RANDOM) \
+    && (PULSE_RANDOM_MIN * PULSE_PRESCALER < PULSE_MIN_INTERVAL \
+        || PULSE_RANDOM_MAX > 0xffff \
+        || PULSE_RANDOM_MIN > PULSE_RANDOM_MAX \
+        || (PULSE_RANDOM_SEED & 0xffff) == 0)
+# error "PULSE_RANDOM_MIN and PULSE_RANDOM_MAX must be within" \
+        " PULSE_MIN_INTERVAL and 0xffff, and PULSE_RANDOM_SEED not 0"
+#endif
+#if defined (PULSE_SWEEP) \
+    && (PULSE_SWEEP_FROM * PULSE_PRESCALER < PULSE_MIN_INTERVAL \
+        || PULSE_SWEEP_TO * PULSE_PRESCALER < PULSE_MIN_INTERVAL \
+        || PULSE_SWEEP_FROM > 0xffff || PULSE_SWEEP_TO > 0xffff \
+        || PULSE_SWEEP_FROM == PULSE_SWEEP_TO || PULSE_SWEEP_STEPS < 1 \
+        || (!defined (PULSE_SWEEP_EXP) && PULSE_SWEEP_STEP == 0))
+# error "PULSE_SWEEP_FROM and PULSE_SWEEP_TO must differ and be within" \
+        " PULSE_MIN_INTERVAL and 0xffff, with a PULSE_SWEEP_STEP not 0"
+#endif
+#if defined (PULSE_DDS) \
+    && ((PULSE_DDS_HIGH >> 16) * PULSE_PRESCALER < PULSE_MIN_INTERVAL \
+        || (PULSE_DDS_LOW >> 16) * PULSE_PRESCALER < PULSE_MIN_INTERVAL \
+        || (PULSE_DDS_HIGH >> 16) > 0xffff || (PULSE_DDS_LOW >> 16) > 0xffff)
+# error "PULSE_DDS_HIGH and PULSE_DDS_LOW must be within" \
+        " PULSE_MIN_INTERVAL and 0xffff timer counts"
+#endif
+#if defined (PULSE_TRIGGER) && defined (PULSE_MULTI)
+# error "PULSE_TRIGGER only starts the OC4 pattern"
+#endif
+#if defined (PULSE_TRIGGER_REARM) \
+    && (defined (PULSE_BURST) || defined (PULSE_EXTENDED) \
+        || defined (PULSE_LOAD) || defined (PULSE_OVERRUN) \
+        || defined (PULSE_FAST) || defined (PULSE_STREAM) \
+        || defined (PULSE_SWEEP) || defined (PULSE_DDS) \
+        || defined (PULSE_RANDOM))
+# error "PULSE_TRIGGER_REARM plays the table once per trigger," \
+        " without skipping or switching it"
+#endif
+#if defined (PULSE_TRIGGER) \
+    && (PULSE_TRIGGER_DELAY * PULSE_PRESCALER < PULSE_MIN_INTERVAL \
+        || PULSE_TRIGGER_DELAY > 0x7fff \
+        || PULSE_TRIGGER_IC < 1 || PULSE_TRIGGER_IC > 3 \
+        || PULSE_TRIGGER_EDGE < 1 || PULSE_TRIGGER_EDGE > 3)
+# error "PULSE_TRIGGER_DELAY must be within PULSE_MIN_INTERVAL and" \
+        " 0x7fff, PULSE_TRIGGER_IC and PULSE_TRIGGER_EDGE within 1 and 3"
+#endif
+#if defined (PULSE_VERIFY) \
+    && (defined (PULSE_EXTENDED) || defined (PULSE_RLE) \
+        || defined (PULSE_LOAD) || defined (PULSE_OVERRUN) \
+        || defined (PULSE_STREAM) || defined (PULSE_SWEEP) \
+        || defined (PULSE_DDS) || defined (PULSE_RANDOM) \
+        || defined (PULSE_TRIGGER) || defined (PULSE_BURST) \
+        || defined (PULSE_FAST))
+# error "PULSE_VERIFY checks a flat cycle_table, one edge per interrupt"
+#endif
+#if defined (PULSE_VERIFY) \
+    && (PULSE_VERIFY_MARGIN < 1 || PULSE_VERIFY_MARGIN > 0x7fff \
+        || PULSE_VERIFY_EDGES > 0xffff)
+# error "PULSE_VERIFY_MARGIN must be within 1 and 0x7fff," \
+        " PULSE_VERIFY_EDGES within 0 and 0xffff"
+#endif
+#if defined (PULSE_STREAM) && (PULSE_STREAM_SIZE & (PULSE_STREAM_SIZE - 1) \
+                               || PULSE_STREAM_SIZE > 128)
+# error "PULSE_STREAM_SIZE must be a power of 2 up to 128"
+#endif
+#if defined (PULSE_TX_BUFFER) && (PULSE_TX_SIZE & (PULSE_TX_SIZE - 1) \
+                                  || PULSE_TX_SIZE < 2 || PULSE_TX_SIZE > 256)
+# error "PULSE_TX_SIZE must be a power of 2 from 2 to 256"
+#endif
+
 #ifdef USE_INTERRUPT_TABLE
 
 /* Interrupt table used to connect our timer_interrupt handler.
@@ -126,7 +543,11 @@ static const unsigned short cycle_table[] = {
    Note: the `XXX_handler: foo' notation is a GNU extension which is
    used here to ensure correct association of the handler in the struct.
    This is why the order of handlers declared below does not follow
-   the HC11 order.  */
+   the HC11 order.
+
+   The Makefile builds this table in pulse-rom.elf.  Without it the
+   handlers are reached through the RAM pseudo-vectors of the monitor,
+   which costs a JMP ext (3 cycles) more on each interrupt.  */
 struct interrupt_vectors __attribute__((section(".vectors"))) vectors = 
 {
   res0_handler:           fatal_interrupt, /* res0 */
@@ -140,18 +561,44 @@ struct interrupt_vectors __attribute__((section(".vectors"))) vectors =
   res8_handler:           fatal_interrupt,
   res9_handler:           fatal_interrupt,
   res10_handler:          fatal_interrupt, /* res 10 */
+#ifdef PULSE_TX_BUFFER
+  sci_handler:            sci_interrupt, /* sci */
+#else
   sci_handler:            fatal_interrupt, /* sci */
+#endif
   spi_handler:            fatal_interrupt, /* spi */
   acc_overflow_handler:   fatal_interrupt, /* acc overflow */
   acc_input_handler:      fatal_interrupt,
   timer_overflow_handler: fatal_interrupt,
+#ifdef PULSE_MULTI
+  output5_handler:        output_compare_5_interrupt, /* out compare 5 */
+  output3_handler:        output_compare_3_interrupt, /* out compare 3 */
+  output2_handler:        output_compare_2_interrupt, /* out compare 2 */
+#else
   output5_handler:        fatal_interrupt, /* out compare 5 */
   output3_handler:        fatal_interrupt, /* out compare 3 */
   output2_handler:        fatal_interrupt, /* out compare 2 */
+#endif
+#ifdef PULSE_VERIFY
+  output1_handler:        verify_timeout_interrupt, /* out compare 1 */
+#else
   output1_handler:        fatal_interrupt, /* out compare 1 */
+#endif
+#if defined (PULSE_TRIGGER) && PULSE_TRIGGER_IC == 3
+  capture3_handler:       input_capture_interrupt, /* in capt 3 */
+#else
   capture3_handler:       fatal_interrupt, /* in capt 3 */
+#endif
+#if defined (PULSE_TRIGGER) && PULSE_TRIGGER_IC == 2
+  capture2_handler:       input_capture_interrupt, /* in capt 2 */
+#else
   capture2_handler:       fatal_interrupt, /* in capt 2 */
+#endif
+#if defined (PULSE_TRIGGER) && PULSE_TRIGGER_IC == 1
+  capture1_handler:       input_capture_interrupt, /* in capt 1 */
+#else
   capture1_handler:       fatal_interrupt, /* in capt 1 */
+#endif
   rtii_handler:           fatal_interrupt,
   irq_handler:            fatal_interrupt, /* IRQ */
   xirq_handler:           fatal_interrupt, /* XIRQ */
@@ -167,70 +614,1605 @@ struct interrupt_vectors __attribute__((section(".vectors"))) vectors =
 
 #endif
 
-static const unsigned short* cycle_next;
-static volatile unsigned char wakeup;
-static unsigned short change_time;
+/* With -DPULSE_FAST the state used on every edge is in page zero,
+   where it is reached with direct addressing (the linker relaxes the
+   accesses when linking with -mrelax, as the GEL boards do).  */
+#ifdef PULSE_FAST
+# define PULSE_PAGE0 __attribute__((section (".page0")))
+#else
+# define PULSE_PAGE0
+#endif
 
-/* Output compare interrupt to setup the new timer.  */
-void
-output_compare_interrupt (void)
+static const unsigned short* cycle_next PULSE_PAGE0;
+
+/* Edges produced, counted by the handler modulo 256.  The main loop
+   keeps its own count of the edges it has handled and works through
+   the difference, so that it sees every edge even when it is slower
+   than some of them (up to 255 edges behind).  An 8-bit counter is
+   read and incremented in one instruction, no masking is needed.
+   `edge_missed' counts the edges which were already produced when the
+   main loop came to wait for them.  */
+static volatile unsigned char edge_count;
+static unsigned short edge_missed;
+static unsigned short change_time PULSE_PAGE0;
+#ifdef PULSE_FAST
+static unsigned short fast_next PULSE_PAGE0;
+#endif
+
+#ifdef PULSE_TRIGGER
+/* Registers of the trigger input.  TMSK1 and TFLG1 have the same bit
+   for a capture.  */
+# if PULSE_TRIGGER_IC == 1
+#  define PULSE_TRIGGER_CAPTURE() get_input_capture_1 ()
+#  define PULSE_TRIGGER_FLAG M6811_IC1F
+#  define PULSE_TRIGGER_SHIFT 4
+#  define PULSE_TRIGGER_VECTOR TIMER_INPUT1_VECTOR
+# elif PULSE_TRIGGER_IC == 2
+#  define PULSE_TRIGGER_CAPTURE() get_input_capture_2 ()
+#  define PULSE_TRIGGER_FLAG M6811_IC2F
+#  define PULSE_TRIGGER_SHIFT 2
+#  define PULSE_TRIGGER_VECTOR TIMER_INPUT2_VECTOR
+# else
+#  define PULSE_TRIGGER_CAPTURE() get_input_capture_3 ()
+#  define PULSE_TRIGGER_FLAG M6811_IC3F
+#  define PULSE_TRIGGER_SHIFT 0
+#  define PULSE_TRIGGER_VECTOR TIMER_INPUT3_VECTOR
+# endif
+
+/* Triggers taken, the fewest timer counts found left between the
+   first compare write and its match, and the triggers for which the
+   first compare was already in the past.  */
+static volatile unsigned short trigger_count;
+static volatile unsigned short trigger_slack = 0xffff;
+static volatile unsigned short trigger_late;
+#endif
+#ifdef PULSE_TRIGGER_REARM
+/* The compare which closes the pass is set.  */
+static unsigned char trigger_done;
+#endif
+
+#ifdef PULSE_LOAD
+/* The active table is played by the interrupt handler while the
+   shadow one is filled by the loader.  The handler only switches to
+   the shadow table when it wraps, so the new pattern starts exactly
+   where the old one ends.  `shadow_ready' hands the shadow table over
+   to the handler and the loader does not touch it until the switch
+   is done.  */
+static unsigned short pattern_ram[2][PULSE_LOAD_SIZE];
+
+/* pulse_init copies cycle_table into the first RAM table: this array
+   gets a negative size, and the build fails, when it does not fit.  */
+typedef char pulse_load_fits[TABLE_SIZE (cycle_table) <= PULSE_LOAD_SIZE
+                             ? 1 : -1];
+static const unsigned short *pattern_start;
+static const unsigned short *pattern_end;
+static const unsigned short *shadow_end;
+static volatile unsigned char shadow_ready;
+static unsigned char active_bank;
+
+/* Timer value when the upload completed and compare value of the
+   first edge of the new pattern.  `load_started' is set when the
+   handler switches to the new pattern and `load_swapped' once the
+   compare of its first edge is set.  */
+static unsigned short load_done_time;
+static volatile unsigned short load_first_edge;
+static unsigned char load_started;
+static volatile unsigned char load_swapped;
+
+# define PATTERN_END pattern_end
+#else
+# define PATTERN_END (&cycle_table[TABLE_SIZE (cycle_table)])
+#endif
+
+/* The pattern is exhausted, start it again (or the new one).  */
+static inline void
+pulse_restart (void)
 {
-  unsigned short dt;
+#ifdef PULSE_LOAD
+  if (shadow_ready)
+    {
+      active_bank ^= 1;
+      pattern_start = pattern_ram[active_bank];
+      pattern_end = shadow_end;
+      shadow_ready = 0;
+      load_started = 1;
+    }
+  cycle_next = pattern_start;
+#else
+  cycle_next = cycle_table;
+#endif
+#ifdef PULSE_TRIGGER_REARM
+  /* The compare just set ends the last interval of the pass.  It
+     must leave PA4 alone, its interrupt waits for the next trigger.  */
+  trigger_done = 1;
+  _io_ports[M6811_TCTL1] &= ~(M6811_OM4 | M6811_OL4);
+#endif
+}
+
+#ifdef PULSE_LOAD
+/* The handler has set `t', the compare of an edge.  The first one
+   after the switch is the first edge of the new pattern: it can't be
+   known in pulse_restart, which may be reached one edge ahead (RLE
+   decoding), from the middle of a long interval or while late edges
+   are being dropped.  */
+static inline void
+pulse_load_edge (unsigned short t)
+{
+  if (load_started)
+    {
+      load_started = 0;
+      load_first_edge = t;
+      load_swapped = 1;
+    }
+}
+#endif
 
-  _io_ports[M6811_TFLG1] |= M6811_OC4F;
+#ifdef PULSE_RLE
+/* Decoder of the run-length encoded table.  `cycle_next' walks the
+   encoded entries and the interval they give is decoded one edge in
+   advance into `rle_next', after the compare is set, so the decoding
+   does not delay the edges.
 
-  /* Setup the new output compare as soon as we can.  */
-  dt = *cycle_next;
-  dt += change_time;
-  set_output_compare_4 (dt);
-  change_time = dt;
+   Reaching the next interval takes at most 2 * PULSE_RLE_DEPTH + 1
+   codes (closing and opening every loop), which bounds the decoding
+   cost of one edge.  Estimated from the generated code:
 
-  /* Prepare for the next interrupt.  */
+     repeated value (fast path)    20 cycles
+     plain value                   35 cycles
+     PULSE_REPEAT                  55 cycles
+     PULSE_LOOP / PULSE_END_LOOP   +40 cycles each
+
+   against 25 cycles for the flat table cursor.  The worst case (4
+   levels) is about 375 cycles, which the handler spends after the
+   compare is set: an interval following such an edge must leave room
+   for it (host/pulserle reports the worst case of a given pattern).  */
+static unsigned short rle_next;
+static unsigned short rle_value;
+static unsigned short rle_count;
+static unsigned char rle_depth;
+static struct
+{
+  const unsigned short *body;
+  unsigned short count;
+} rle_stack[PULSE_RLE_DEPTH];
+
+static void
+pulse_rle_fetch (void)
+{
+  unsigned short w;
+
+  if (rle_count)
+    {
+      rle_count--;
+      rle_next = rle_value;
+      return;
+    }
+  for (;;)
+    {
+      if (cycle_next >= PATTERN_END)
+        pulse_restart ();
+
+      w = *cycle_next++;
+      if (w >= PULSE_CODE_LIMIT)
+        {
+          rle_next = w;
+          return;
+        }
+      switch (w)
+        {
+        case PULSE_REPEAT:
+          rle_count = cycle_next[0] - 1;
+          rle_value = cycle_next[1];
+          rle_next = rle_value;
+          cycle_next += 2;
+          return;
+
+        case PULSE_LOOP:
+          rle_stack[rle_depth].count = *cycle_next++;
+          rle_stack[rle_depth].body = cycle_next;
+          rle_depth++;
+          break;
+
+        case PULSE_END_LOOP:
+          if (--rle_stack[rle_depth - 1].count)
+            cycle_next = rle_stack[rle_depth - 1].body;
+          else
+            rle_depth--;
+          break;
+        }
+    }
+}
+#endif
+
+#ifdef PULSE_STREAM
+/* Stream FIFO.  The main loop is the only writer of `stream_head' and
+   the handler the only writer of `stream_tail'; both count entries
+   modulo 256 and the FIFO holds `stream_head - stream_tail' of them.
+   `stream_granted' is the value of `stream_tail' up to which the host
+   was given its credit back.
+
+   Until the host starts the stream (`stream_on'), the handler plays
+   `cycle_table'.  Like the RLE decoder, the interval of the next edge
+   is fetched one edge in advance into `stream_next', after the
+   compare is set: taking an entry from the FIFO costs about 30
+   cycles there and nothing before the compare.  When the FIFO is
+   empty the last interval is played again and counted in
+   `stream_underrun': the link did not keep up with the edges and the
+   rest of the trace comes that much later.  Once the host has marked
+   the end of the stream, an empty FIFO returns to `cycle_table'
+   instead.  */
+static unsigned short stream_buf[PULSE_STREAM_SIZE];
+static volatile unsigned char stream_head;
+static volatile unsigned char stream_tail;
+static unsigned char stream_granted;
+static volatile unsigned char stream_on;
+static volatile unsigned char stream_finish;
+static volatile unsigned short stream_underrun;
+static unsigned short stream_next;
+
+static void
+pulse_stream_fetch (void)
+{
+  if (stream_on)
+    {
+      if (stream_head != stream_tail)
+        {
+          stream_next = stream_buf[stream_tail & (PULSE_STREAM_SIZE - 1)];
+          stream_tail++;
+          return;
+        }
+      if (!stream_finish)
+        {
+          stream_underrun++;
+          return;
+        }
+      stream_on = 0;
+      cycle_next = cycle_table;
+    }
+  else
+    {
+      cycle_next++;
+      if (cycle_next >= PATTERN_END)
+        pulse_restart ();
+    }
+  stream_next = *cycle_next;
+}
+#endif
+
+#ifdef PULSE_SWEEP
+/* Sweep generator.  `sweep_interval' is the interval of the next edge
+   in timer counts, with 16 bits of fraction: the handler uses its
+   high word as is and the fraction carries from one edge to the next,
+   so the edges stay within one count of the exact sweep and
+   `change_time' accumulates them without drift like table entries.
+   Each edge only adds a constant to it (linear sweep) or the interval
+   shifted right by PULSE_SWEEP_SHIFT (exponential sweep), after the
+   compare is set; there is no multiply or divide.  The step of the
+   linear sweep, PULSE_SWEEP_STEP, is computed by the compiler.
+
+   Estimated from the generated code, against 25 cycles for the flat
+   table cursor: about 40 cycles per edge for the linear sweep, and 40
+   plus about 8 per bit of PULSE_SWEEP_SHIFT below 16 for the
+   exponential one (none above).  This is all after the compare: the
+   interval is read with one 16-bit load before it.  host/isrcycles
+   gives the exact figures of a build.  */
+#define PULSE_SWEEP_START ((unsigned long) PULSE_SWEEP_FROM << 16)
+#define PULSE_SWEEP_END   ((unsigned long) PULSE_SWEEP_TO << 16)
+
+static unsigned long sweep_interval;
+
+static inline void
+pulse_sweep_step (void)
+{
+#ifdef PULSE_SWEEP_EXP
+# if PULSE_SWEEP_TO < PULSE_SWEEP_FROM
+  sweep_interval -= sweep_interval >> PULSE_SWEEP_SHIFT;
+  if (sweep_interval < PULSE_SWEEP_END)
+    sweep_interval = PULSE_SWEEP_START;
+# else
+  sweep_interval += sweep_interval >> PULSE_SWEEP_SHIFT;
+  if (sweep_interval > PULSE_SWEEP_END)
+    sweep_interval = PULSE_SWEEP_START;
+# endif
+#else
+  /* The step is compared before it is added: one larger than the end
+     of a downward sweep (or than what is left above that of an upward
+     one) would wrap the accumulator.  PULSE_SWEEP_START is at least
+     one step from the end, so the bound fits 32 bits.  */
+# if PULSE_SWEEP_TO < PULSE_SWEEP_FROM
+  if (sweep_interval
+      < (unsigned long) (PULSE_SWEEP_END - PULSE_SWEEP_STEP))
+# else
+  if (sweep_interval
+      > (unsigned long) (PULSE_SWEEP_END - PULSE_SWEEP_STEP))
+# endif
+    sweep_interval = PULSE_SWEEP_START;
+  else
+    sweep_interval += PULSE_SWEEP_STEP;
+#endif
+}
+#endif
+
+#ifdef PULSE_DDS
+/* Fractional intervals, like the phase accumulator of a DDS.  The
+   fractions of the intervals are added up in `dds_frac' next to
+   `change_time': each carry makes the interval one count longer, so
+   the intervals alternate between the two counts around the exact
+   value and the edges stay within one count of their exact place
+   forever.  The average frequency is exact to 2^-16 count per
+   interval (a fraction of a ppm), where a table can only round each
+   interval to a count (0.5 us by default).
+
+   The next interval is computed after the compare is set, about 25
+   cycles with a 16-bit add and the carry test (35 when the high and
+   low intervals differ), the same as the table cursor.  */
+static unsigned short dds_frac;
+static unsigned short dds_next;
+#ifndef PULSE_DDS_SQUARE
+static unsigned char dds_high;
+#endif
+
+static inline void
+pulse_dds_step (void)
+{
+  unsigned short f;
+
+#ifndef PULSE_DDS_SQUARE
+  dds_high ^= 1;
+  if (!dds_high)
+    {
+      f = dds_frac + (unsigned short) PULSE_DDS_LOW;
+      dds_next = (unsigned short) (PULSE_DDS_LOW >> 16) + (f < dds_frac);
+      dds_frac = f;
+      return;
+    }
+#endif
+  f = dds_frac + (unsigned short) PULSE_DDS_HIGH;
+  dds_next = (unsigned short) (PULSE_DDS_HIGH >> 16) + (f < dds_frac);
+  dds_frac = f;
+}
+#endif
+
+#ifdef PULSE_RANDOM
+/* Pseudo-random intervals.  The generator is a 16-bit xorshift (7, 9,
+   8), which is a linear feedback shift register advanced by several
+   bits at once: it goes through the 65535 non-zero states before the
+   sequence repeats, and consecutive values are not shifted copies of
+   each other as with a single LFSR step.  The same seed always gives
+   the same intervals (host/pulsesim prints them).
+
+   The value is brought within the bounds without a division: it is
+   masked with PULSE_RANDOM_MASK, the smallest all-ones value covering
+   PULSE_RANDOM_MAX - PULSE_RANDOM_MIN, and folded once into the range
+   when it is above.  The low part of the range is then twice as
+   likely as the rest when the range is not a power of 2 minus 1.
+
+   The next interval is computed after the compare is set, with no
+   loop: about 45 cycles (shifts by 7 and 9 and two byte moves, the
+   mask, the fold and the add) whatever the value, against 25 for the
+   table cursor.
+
+   Short intervals can follow each other, so PULSE_RANDOM_MIN must
+   also leave the time of a whole interrupt, more than the single
+   short interval PULSE_MIN_INTERVAL is checked against: 137 cycles
+   on host/pulsesim, and what host/isrcycles writes in pulse.min for a
+   build.  */
+#define PULSE_RANDOM_RANGE (PULSE_RANDOM_MAX - PULSE_RANDOM_MIN)
+#define PULSE_RANDOM_SMEAR(R, N) ((R) | ((R) >> (N)))
+#define PULSE_RANDOM_MASK \
+   PULSE_RANDOM_SMEAR (PULSE_RANDOM_SMEAR (PULSE_RANDOM_SMEAR \
+     (PULSE_RANDOM_SMEAR (PULSE_RANDOM_RANGE, 1), 2), 4), 8)
+
+static unsigned short random_state;
+static unsigned short random_next;
+
+static inline void
+pulse_random_step (void)
+{
+  unsigned short r = random_state;
+
+  r ^= r << 7;
+  r ^= r >> 9;
+  r ^= r << 8;
+  random_state = r;
+
+  r &= PULSE_RANDOM_MASK;
+  if (r > PULSE_RANDOM_RANGE)
+    r -= (PULSE_RANDOM_MASK >> 1) + 1;
+  random_next = r + PULSE_RANDOM_MIN;
+}
+#endif
+
+#ifdef PULSE_OVERRUN
+/* Number of compares which were already in the past (or too close)
+   when the handler came to set them.  */
+static volatile unsigned short overrun_count;
+
+/* Interval of the next edge and move to the one after it.  */
+static inline unsigned short
+pulse_next (void)
+{
+#ifdef PULSE_RLE
+  return rle_next;
+#else
+  return *cycle_next;
+#endif
+}
+
+static inline void
+pulse_advance (void)
+{
+#ifdef PULSE_RLE
+  pulse_rle_fetch ();
+#else
   cycle_next++;
-  if (cycle_next >= &cycle_table[TABLE_SIZE (cycle_table)])
-    cycle_next = cycle_table;
+  if (cycle_next >= PATTERN_END)
+    pulse_restart ();
+#endif
+}
 
-  wakeup = 1;
+/* Whether the compare value `dt' is less than PULSE_OVERRUN_GUARD
+   counts ahead of TCNT.  Both are taken from `change_time', the edge
+   which has just matched, so that intervals above 0x7fff are not seen
+   as already in the past.  */
+static inline int
+pulse_late (unsigned short dt)
+{
+  return (unsigned short) (get_timer_counter () - change_time)
+    > (unsigned short) (dt - change_time) - PULSE_OVERRUN_GUARD;
 }
 
-int
-main ()
+/* The handler was delayed so much that `dt', the compare value of the
+   next edge, has passed or is about to.  Set as is, it would only
+   match after the counter wraps and leave a 32 ms hole.  Return the
+   compare value to set instead, keeping the cursor on the interval it
+   ends so that the handler moves on as usual:
+
+   - by default the edges which can't be made are dropped two by two
+     and the pattern resumes on the first pair still ahead, so the pin
+     keeps its level and its phase (the skipped edges never appear);
+
+   - with -DPULSE_OVERRUN_FORCE each missed edge is produced right
+     away through CFORC, and counted in `edge_count' like the others;
+     the following ones keep their place, so the pattern is only late
+     until it catches up with TCNT.
+
+   Both cost one TCNT read and a test per edge when nothing is late.  */
+static unsigned short
+pulse_overrun (unsigned short dt)
 {
-  unsigned short j;
-  unsigned char c = 0;
-  unsigned char i = 0;
-  
-  lock ();
-  serial_init ();
+  overrun_count++;
+  do
+    {
+#ifdef PULSE_OVERRUN_FORCE
+      _io_ports[M6811_CFORC] = M6811_FOC4;
+      edge_count++;
+      pulse_advance ();
+      dt += pulse_next ();
+#else
+      pulse_advance ();
+      dt += pulse_next ();
+      pulse_advance ();
+      dt += pulse_next ();
+#endif
+    }
+  while (pulse_late (dt));
+  return dt;
+}
+#endif
 
-  /* Install the interrupt handler (unless we use the interrupt table).  */
-  set_interrupt_handler (TIMER_OUTPUT4_VECTOR, output_compare_interrupt);
+#ifdef PULSE_LATENCY
+/* Latency histogram.  The handler reads TCNT as its first statement
+   and subtracts the compare value which has just matched: this is the
+   time from the edge to the handler body, that is the latency shown
+   by `sim info' plus the interrupt frame, the vector dispatch and the
+   handler prologue (about 45 cycles at best).  The bucket is updated
+   once the next compare is set, so only the TCNT read (about 10
+   cycles) delays the edges.  Without -DPULSE_LATENCY none of this is
+   compiled in.  The last bucket also counts the longer latencies and
+   the counts stop at 65535.  */
+static unsigned short latency_hist[PULSE_LATENCY_BUCKETS];
+static unsigned short latency_max;
 
-  cycle_next = cycle_table;
+static inline void
+pulse_latency_record (unsigned short latency)
+{
+  unsigned short i = latency >> PULSE_LATENCY_SHIFT;
 
-  /* Set OC4 compare to toggle the output pin.  */
-  _io_ports[M6811_TCTL1] = M6811_OL4;
-  _io_ports[M6811_TMSK1] = M6811_OC4I;
+  if (i >= PULSE_LATENCY_BUCKETS)
+    i = PULSE_LATENCY_BUCKETS - 1;
+  if (latency_hist[i] != 0xffff)
+    latency_hist[i]++;
+  if (latency > latency_max)
+    latency_max = latency;
+}
+#endif
 
-  /* Start the pulse generation.  */
-  change_time = get_timer_counter () + 300;
-  set_output_compare_4 (change_time);
-  unlock ();
+#ifdef PULSE_EXTENDED
+/* A long interval is made of `long_steps' compares of 0x8000 cycles
+   which leave PA4 alone, followed by a compare of `long_last' cycles
+   which toggles it.  Each step is added to `change_time' like any
+   other interval, so the whole interval stays exact.  */
+static unsigned short long_steps;
+static unsigned short long_last;
 
-  for (j = 0; j < 1000; j++)
+/* Start the long interval at `cycle_next' (PULSE_LONG, high, low).  */
+static void
+pulse_long_start (void)
+{
+  unsigned short lo = cycle_next[2];
+
+#ifdef PULSE_LOAD
+  /* The last step toggles PA4 `lo' cycles (modulo 65536) after the
+     start of the interval.  */
+  pulse_load_edge (change_time + lo);
+#endif
+
+  /* Split the count so that the last step is 0x8000 to 0xffff
+     cycles: it stays well above what the handler needs.  A count
+     below 65536 would give no step or 0xffff of them: it is played as
+     a plain interval.  */
+  if (cycle_next[1] == 0)
     {
-      /* Wait for the output compare interrupt to be raised.  */
-      wakeup = 0;
-      while (wakeup == 0)
-        continue;
+      change_time += lo;
+      set_output_compare_4 (change_time);
+    }
+  else
+    {
+      long_steps = cycle_next[1] << 1;
+      if (lo < 0x8000)
+        {
+          long_steps--;
+          lo += 0x8000;
+        }
+      long_last = lo;
 
-      /* Produce some activity on serial line so that we know
-         it is running and interrupts are raised/caught correctly.  */
-      c++;
-      if (c == 1)
-        serial_send ('\b');
-      else if (c == 128)
-        serial_send ("-\\|/"[(++i) & 3]);
+      _io_ports[M6811_TCTL1] &= ~(M6811_OM4 | M6811_OL4);
+      change_time += 0x8000;
+      set_output_compare_4 (change_time);
+    }
+
+  cycle_next += 3;
+  if (cycle_next >= PATTERN_END)
+    pulse_restart ();
+}
+
+/* An intermediate compare of a long interval has matched.  */
+static void
+pulse_long_step (void)
+{
+  long_steps--;
+  if (long_steps)
+    change_time += 0x8000;
+  else
+    {
+      change_time += long_last;
+      _io_ports[M6811_TCTL1] |= M6811_OL4;
     }
+  set_output_compare_4 (change_time);
+}
+#endif
+
+#ifdef PULSE_VERIFY
+/* Self test of the timing, PA4 being wired to PA0/IC3.  The capture
+   latches TCNT at each edge of PA4 (both edges are selected), so the
+   intervals are measured on the pin, to the timer count, whatever the
+   latency of the handler.  The first edge starts the check and edge
+   N > 0 ends the interval of entry N - 1 of `cycle_table'.
+
+   The capture is read by the OC4 handler of its edge, once the next
+   compare is set, as the latency histogram is: a capture interrupt
+   would cost a whole interrupt more per edge and the default table
+   has no room for it.  About 40 cycles are added to the interrupt.
+
+   The intervals are only known modulo the counter turn, which would
+   hide an edge one turn late (a compare set after its time).  OC1
+   watches for this: it is set PULSE_VERIFY_MARGIN counts after the
+   edge just programmed and counts it missing when its interrupt comes
+   first.  An interval longer than 0xffff - PULSE_VERIFY_MARGIN would
+   put the watch past one counter turn, where it would match before
+   the edge: OC1 is left off for such an interval.  OC1 does not drive
+   any pin here.  */
+static const unsigned short *verify_next;
+static unsigned short verify_last;
+static unsigned char verify_started;
+
+/* Intervals checked, intervals out of tolerance (missing edges
+   included) and the largest error seen, in timer counts (0xffff for
+   a missing edge).  `verify_done' is set when the check is over.  */
+static volatile unsigned short verify_edges;
+static volatile unsigned short verify_errors;
+static volatile unsigned short verify_max;
+static volatile unsigned char verify_done;
+
+static inline void
+pulse_verify_edge (void)
+{
+  unsigned short tic;
+  unsigned short error;
+
+  if (verify_done)
+    return;
+
+  tic = get_input_capture_3 ();
+  if (*cycle_next <= 0xffff - PULSE_VERIFY_MARGIN)
+    {
+      set_output_compare_1 (change_time + PULSE_VERIFY_MARGIN);
+      _io_ports[M6811_TFLG1] = M6811_OC1F;
+      _io_ports[M6811_TMSK1] |= M6811_OC1I;
+    }
+  else
+    _io_ports[M6811_TMSK1] &= ~M6811_OC1I;
+
+  if (verify_started)
+    {
+      error = tic - verify_last - *verify_next;
+      if ((short) error < 0)
+        error = -error;
+      if (error > PULSE_VERIFY_TOLERANCE)
+        verify_errors++;
+      if (error > verify_max)
+        verify_max = error;
+      verify_next++;
+      if (verify_next >= PATTERN_END)
+        verify_next = cycle_table;
+#if PULSE_VERIFY_EDGES != 0
+      if (++verify_edges == PULSE_VERIFY_EDGES)
+        {
+          _io_ports[M6811_TMSK1] &= ~M6811_OC1I;
+          verify_done = 1;
+        }
+#else
+      verify_edges++;
+#endif
+    }
+  verify_started = 1;
+  verify_last = tic;
+}
+
+/* The edge programmed by the last OC4 interrupt has not come in
+   time.  The next interrupt sets the watch again.  */
+void
+verify_timeout_interrupt (void)
+{
+  _io_ports[M6811_TFLG1] = M6811_OC1F;
+  verify_errors++;
+  verify_max = 0xffff;
+}
+#endif
+
+#ifdef PULSE_TRIGGER_REARM
+/* The pass is over: stop the OC4 interrupts and take the next
+   trigger.  The edges which came during the pass are forgotten.  */
+static void
+pulse_trigger_wait (void)
+{
+  trigger_done = 0;
+  _io_ports[M6811_TMSK1] &= ~M6811_OC4I;
+  _io_ports[M6811_TFLG1] = PULSE_TRIGGER_FLAG;
+  _io_ports[M6811_TMSK1] |= PULSE_TRIGGER_FLAG;
+}
+#endif
+
+#ifdef PULSE_FAST
+/* Output compare interrupt, tuned for the shortest path to the next
+   compare.  The interval of the next edge is loaded one edge ahead
+   into `fast_next', so that setting the compare is only an add and
+   two stores, and the end of the table is found on the PULSE_FAST_END
+   marker by the load itself instead of comparing the cursor against
+   the end address.  The flag is acknowledged with a plain store, as
+   TFLG1 is write-one-to-clear.
+
+   Estimated cycles from the m6811-elf-gcc -Os code, and what
+   host/pulsesim charges for them:
+
+                                   normal    PULSE_FAST
+     prologue (soft registers)       24          8
+     match to compare written        76         53
+     whole interrupt                136        105
+
+   A steady train of equal intervals needs the whole interrupt, so
+   the shortest one goes from 136 to 105 cycles, and a single short
+   interval between two long ones from 80 to 57 cycles.  These are
+   estimates: host/pulsesim only charges the figures above, so it
+   gives them back and does not measure them; host/isrcycles derives
+   the real ones from the disassembly of a build (PULSE_MIN_INTERVAL
+   keeps its margin for the normal handler).  */
+void
+output_compare_interrupt (void)
+{
+  _io_ports[M6811_TFLG1] = M6811_OC4F;
+
+  change_time += fast_next;
+  set_output_compare_4 (change_time);
+
+  fast_next = *++cycle_next;
+  if (fast_next == PULSE_FAST_END)
+    {
+      cycle_next = cycle_table;
+      fast_next = *cycle_next;
+    }
+  edge_count++;
+}
+#else
+/* Output compare interrupt to setup the new timer.  */
+void
+output_compare_interrupt (void)
+{
+  unsigned short dt;
+#ifdef PULSE_BURST
+  unsigned short last;
+#endif
+#ifdef PULSE_LATENCY
+  unsigned short latency;
+
+  latency = get_timer_counter () - change_time;
+#endif
+
+  /* TFLG1 is write-one-to-clear: a read-modify-write would also clear
+     the pending flags of the other compares and captures.  */
+  _io_ports[M6811_TFLG1] = M6811_OC4F;
+
+#ifdef PULSE_EXTENDED
+  /* This test is the whole cost of the extended mode on a normal
+     edge (about 8 cycles before the compare is set).  */
+  if (long_steps)
+    {
+      pulse_long_step ();
+#ifdef PULSE_LATENCY
+      pulse_latency_record (latency);
+#endif
+      return;
+    }
+#endif
+#ifdef PULSE_TRIGGER_REARM
+  if (trigger_done)
+    {
+      pulse_trigger_wait ();
+      return;
+    }
+#endif
+
+  /* Setup the new output compare as soon as we can.  */
+#ifdef PULSE_RLE
+  dt = rle_next;
+#elif defined (PULSE_STREAM)
+  dt = stream_next;
+#elif defined (PULSE_SWEEP)
+  dt = sweep_interval >> 16;
+#elif defined (PULSE_DDS)
+  dt = dds_next;
+#elif defined (PULSE_RANDOM)
+  dt = random_next;
+#else
+  dt = *cycle_next;
+#endif
+#ifdef PULSE_EXTENDED
+  if (dt == PULSE_LONG)
+    {
+      pulse_long_start ();
+#ifdef PULSE_LATENCY
+      pulse_latency_record (latency);
+#endif
+      edge_count++;
+      return;
+    }
+#endif
+  dt += change_time;
+#ifdef PULSE_OVERRUN
+  if (pulse_late (dt))
+    dt = pulse_overrun (dt);
+#endif
+  set_output_compare_4 (dt);
+#ifdef PULSE_LOAD
+  pulse_load_edge (dt);
+#endif
+#ifdef PULSE_BURST
+  last = *cycle_next;
+#endif
+  change_time = dt;
+#ifdef PULSE_LATENCY
+  pulse_latency_record (latency);
+#endif
+#ifdef PULSE_VERIFY
+  pulse_verify_edge ();
+#endif
+
+  /* Prepare for the next interrupt.  */
+#ifdef PULSE_RLE
+  pulse_rle_fetch ();
+#elif defined (PULSE_STREAM)
+  pulse_stream_fetch ();
+#elif defined (PULSE_SWEEP)
+  pulse_sweep_step ();
+#elif defined (PULSE_DDS)
+  pulse_dds_step ();
+#elif defined (PULSE_RANDOM)
+  pulse_random_step ();
+#else
+  cycle_next++;
+  if (cycle_next >= PATTERN_END)
+    pulse_restart ();
+#endif
+
+#ifdef PULSE_BURST
+  /* Burst mode: if the interval we just programmed or the next one is
+     too short, the next interrupt would be taken too late to set the
+     compare that follows it.  Stay in the handler instead: poll TCNT
+     until the pending compare has matched and program the next one
+     right away.  The edges are still produced by the OC4 hardware so
+     they keep their exact, drift-free position; the loop only has to
+     set each compare before it is due (about 60 cycles per edge).
+
+     We leave once the last programmed interval leaves the time of a
+     whole interrupt, so that the next one is not delayed by this one,
+     and its successor is long enough for the normal interrupt path.
+     The flag of the pending compare must then be kept (it is cleared
+     per edge here).  A pattern made only of short intervals never
+     returns to main.  */
+  while (last < PULSE_BURST_RUN || *cycle_next < PULSE_BURST_LIMIT)
+    {
+      while ((short) (get_timer_counter () - change_time) < 0)
+        continue;
+      _io_ports[M6811_TFLG1] = M6811_OC4F;
+      edge_count++;
+
+      last = *cycle_next;
+      change_time += last;
+      set_output_compare_4 (change_time);
+#ifdef PULSE_LOAD
+      pulse_load_edge (change_time);
+#endif
+
+      cycle_next++;
+      if (cycle_next >= PATTERN_END)
+        pulse_restart ();
+    }
+#endif
+
+  edge_count++;
+}
+#endif
+
+#ifdef PULSE_MULTI
+/* State of the OC2, OC3 and OC5 pulse trains.  Each channel keeps its
+   own cursor and its own `change_time' so that it is drift-free on its
+   own, exactly like the OC4 one.
+
+   There is one small handler per compare: the vector tells which
+   compare fired at no cost, and the hardware priority (OC2 first,
+   then OC3, OC4 and OC5) orders the channels when several compares
+   match together.  A handler cannot be preempted, so in the worst
+   case a channel has to wait for the handlers of all the channels of
+   higher priority plus the one in progress before it can set its
+   next compare.  With about 136 cycles for a complete handler and 80
+   from a match to the new compare, this gives the minimum interval
+   of each channel when all four can match at the same time:
+
+     OC2 (PA6)       136 + 80 = 216 cycles
+     OC3 (PA5)   2 x 136 + 80 = 352 cycles
+     OC4 (PA4)   3 x 136 + 80 = 488 cycles
+     OC5 (PA3)   3 x 136 + 80 = 488 cycles
+
+   A channel which can fire twice within one of these windows adds its
+   handler once more to the channels below it.  Channels whose edges
+   never coincide keep the 100 cycles limit: the 100 us entries of
+   `cycle_table' are below the OC4 figure, and the default tables of
+   the other channels keep away from them (host/pulsesim built with
+   PULSE_FLAGS=-DPULSE_MULTI shows no late edge).  */
+struct pulse_channel
+{
+  const unsigned short *next;   /* Next interval to program.  */
+  const unsigned short *table;  /* First and last+1 entries of the  */
+  const unsigned short *end;    /* channel pattern.  */
+  unsigned short change_time;   /* Compare value of the pending edge.  */
+};
+
+static struct pulse_channel oc2_channel;
+static struct pulse_channel oc3_channel;
+static struct pulse_channel oc5_channel;
+
+/* Compare value of the edge that follows the one which fired.  */
+static inline unsigned short
+pulse_channel_time (struct pulse_channel *ch)
+{
+  ch->change_time += *ch->next;
+  return ch->change_time;
+}
+
+static inline void
+pulse_channel_advance (struct pulse_channel *ch)
+{
+  ch->next++;
+  if (ch->next >= ch->end)
+    ch->next = ch->table;
+}
+
+static void
+pulse_channel_start (struct pulse_channel *ch, const unsigned short *table,
+                     unsigned short size, unsigned short start)
+{
+  ch->table = table;
+  ch->next = table;
+  ch->end = &table[size];
+  ch->change_time = start;
+}
+
+void
+output_compare_2_interrupt (void)
+{
+  _io_ports[M6811_TFLG1] = M6811_OC2F;
+  set_output_compare_2 (pulse_channel_time (&oc2_channel));
+  pulse_channel_advance (&oc2_channel);
+}
+
+void
+output_compare_3_interrupt (void)
+{
+  _io_ports[M6811_TFLG1] = M6811_OC3F;
+  set_output_compare_3 (pulse_channel_time (&oc3_channel));
+  pulse_channel_advance (&oc3_channel);
+}
+
+void
+output_compare_5_interrupt (void)
+{
+  _io_ports[M6811_TFLG1] = M6811_I4O5F;
+  set_output_compare_5 (pulse_channel_time (&oc5_channel));
+  pulse_channel_advance (&oc5_channel);
+}
+#endif
+
+#ifdef PULSE_TRIGGER
+/* Trigger input.  The capture latches TCNT in hardware when the edge
+   comes, so the first compare is set from the time of the edge, not
+   from the time this handler runs: the first edge of the pattern
+   always comes PULSE_TRIGGER_DELAY timer counts after the trigger
+   (within one count of prescaler phase), whatever the interrupt
+   latency.  Until then OC4 leaves PA4 alone and raises no interrupt.
+
+   The delay must cover the interrupt entry and the compare write,
+   about the same path as a short interval after a long one, hence
+   the PULSE_MIN_INTERVAL check.  The handler then reads TCNT to
+   measure what was left of the delay (`T' serial command).  A
+   trigger taken too late has its first edge one counter turn later,
+   and is counted.  */
+void
+input_capture_interrupt (void)
+{
+  unsigned short slack;
+
+  change_time = PULSE_TRIGGER_CAPTURE () + PULSE_TRIGGER_DELAY;
+
+  /* One trigger per pass; without -DPULSE_TRIGGER_REARM, the only
+     one.  The stale OC4F is cleared before the compare is armed, so
+     that a match coming right after cannot be lost.  */
+  _io_ports[M6811_TMSK1] &= ~PULSE_TRIGGER_FLAG;
+  _io_ports[M6811_TFLG1] = M6811_OC4F | PULSE_TRIGGER_FLAG;
+  set_output_compare_4 (change_time);
+  _io_ports[M6811_TCTL1] |= M6811_OL4;
+  _io_ports[M6811_TMSK1] |= M6811_OC4I;
+
+  slack = change_time - get_timer_counter ();
+  trigger_count++;
+  if ((short) slack <= 0)
+    trigger_late++;
+  else if (slack < trigger_slack)
+    trigger_slack = slack;
+}
+#endif
+
+#if PULSE_PRESCALER != 1
+/* Select the timer prescaler.  The PR1/PR0 bits of TMSK2 can only be
+   written in the first 64 E clock cycles after reset (in normal
+   modes), so this must be done by __premain which the GEL startup
+   calls before main.  Under a monitor the prescaler it has chosen
+   stays in effect.  */
+void
+__premain (void)
+{
+  _io_ports[M6811_TMSK2] = (_io_ports[M6811_TMSK2]
+                            & ~(M6811_PR1 | M6811_PR0)) | PULSE_PR_BITS;
+}
+#endif
+
+/* Setup the timer and start the pulse generation.  This is also
+   the entry point used by the host model (see host/pulsesim.c).  */
+static void
+pulse_init (void)
+{
+#ifdef PULSE_LOAD
+  unsigned short j;
+#endif
+
+  lock ();
+  serial_init ();
+
+  /* Install the interrupt handler (unless we use the interrupt table).  */
+  set_interrupt_handler (TIMER_OUTPUT4_VECTOR, output_compare_interrupt);
+#ifdef PULSE_TX_BUFFER
+  set_interrupt_handler (SCI_VECTOR, sci_interrupt);
+#endif
+
+#ifdef PULSE_LOAD
+  for (j = 0; j < TABLE_SIZE (cycle_table); j++)
+    pattern_ram[0][j] = cycle_table[j];
+  pattern_start = pattern_ram[0];
+  pattern_end = &pattern_ram[0][TABLE_SIZE (cycle_table)];
+  cycle_next = pattern_start;
+#else
+  cycle_next = cycle_table;
+#endif
+#ifdef PULSE_RLE
+  pulse_rle_fetch ();
+#endif
+#ifdef PULSE_STREAM
+  stream_next = *cycle_next;
+#endif
+#ifdef PULSE_SWEEP
+  sweep_interval = PULSE_SWEEP_START;
+#endif
+#ifdef PULSE_DDS
+  pulse_dds_step ();
+#endif
+#ifdef PULSE_RANDOM
+  random_state = PULSE_RANDOM_SEED;
+  pulse_random_step ();
+#endif
+#ifdef PULSE_FAST
+  fast_next = *cycle_next;
+#endif
+
+  /* Set OC4 compare to toggle the output pin.  */
+  _io_ports[M6811_TCTL1] = M6811_OL4;
+  _io_ports[M6811_TMSK1] = M6811_OC4I;
+
+#ifdef PULSE_MULTI
+  set_interrupt_handler (TIMER_OUTPUT2_VECTOR, output_compare_2_interrupt);
+  set_interrupt_handler (TIMER_OUTPUT3_VECTOR, output_compare_3_interrupt);
+  set_interrupt_handler (TIMER_OUTPUT5_VECTOR, output_compare_5_interrupt);
+  _io_ports[M6811_PACTL] &= ~M6811_I4O5;
+  _io_ports[M6811_TCTL1] = M6811_OL2 | M6811_OL3 | M6811_OL4 | M6811_OL5;
+  _io_ports[M6811_TMSK1] = M6811_OC2I | M6811_OC3I | M6811_OC4I | M6811_I4O5I;
+#endif
+
+#ifdef PULSE_VERIFY
+  /* Capture both edges on PA0/IC3, without interrupt.  */
+  set_interrupt_handler (TIMER_OUTPUT1_VECTOR, verify_timeout_interrupt);
+  verify_next = cycle_table;
+  _io_ports[M6811_OC1M] = 0;
+  _io_ports[M6811_TCTL2] = M6811_EDG3B | M6811_EDG3A;
+#endif
+
+  /* Start the pulse generation.  */
+#ifdef PULSE_TRIGGER
+  set_interrupt_handler (PULSE_TRIGGER_VECTOR, input_capture_interrupt);
+  _io_ports[M6811_TCTL1] = 0;
+  _io_ports[M6811_TCTL2] = PULSE_TRIGGER_EDGE << PULSE_TRIGGER_SHIFT;
+  _io_ports[M6811_TFLG1] = PULSE_TRIGGER_FLAG;
+  _io_ports[M6811_TMSK1] = PULSE_TRIGGER_FLAG;
+#else
+  change_time = get_timer_counter () + 300;
+  set_output_compare_4 (change_time);
+#endif
+#ifdef PULSE_VERIFY
+  set_output_compare_1 (change_time + PULSE_VERIFY_MARGIN);
+  _io_ports[M6811_TFLG1] = M6811_OC1F;
+  _io_ports[M6811_TMSK1] |= M6811_OC1I;
+#endif
+#ifdef PULSE_MULTI
+  /* The channels start apart so that their edges never pile up, nor
+     meet the short intervals of `cycle_table'.  */
+  pulse_channel_start (&oc2_channel, oc2_table, TABLE_SIZE (oc2_table),
+                       change_time + US_TO_CYCLE (300));
+  set_output_compare_2 (oc2_channel.change_time);
+  pulse_channel_start (&oc3_channel, oc3_table, TABLE_SIZE (oc3_table),
+                       change_time + US_TO_CYCLE (500));
+  set_output_compare_3 (oc3_channel.change_time);
+  pulse_channel_start (&oc5_channel, oc5_table, TABLE_SIZE (oc5_table),
+                       change_time + US_TO_CYCLE (900));
+  set_output_compare_5 (oc5_channel.change_time);
+#endif
+  unlock ();
+}
+
+#ifdef PULSE_TX_BUFFER
+/* Transmit ring buffer.  The main loop is the only writer of
+   `tx_head' and the SCI interrupt the only writer of `tx_tail', so
+   neither needs to mask the interrupts.  The SCI interrupt has the
+   lowest priority of the chip: it is only taken when no compare is
+   pending and its handler is short (one byte per interrupt), which
+   delays an edge by less than the handlers of the other channels.  */
+static unsigned char tx_buf[PULSE_TX_SIZE];
+static volatile unsigned char tx_head;
+static volatile unsigned char tx_tail;
+
+/* TDRE is set: send the next byte, or stop the transmit interrupts
+   when there is none.  The interrupt is raised as long as TDRE is
+   set, so serial_send does not wait here.  */
+void
+sci_interrupt (void)
+{
+  if (tx_tail != tx_head)
+    {
+      serial_send (tx_buf[tx_tail]);
+      tx_tail = (tx_tail + 1) & (PULSE_TX_SIZE - 1);
+    }
+  else
+    _io_ports[M6811_SCCR2] &= ~M6811_TIE;
+}
+
+/* Queue `c' unless the buffer is full.  Setting TIE after `tx_head'
+   is updated is what makes a concurrent SCI interrupt harmless: if it
+   has just found the buffer empty and cleared TIE, it is set again.  */
+static unsigned char
+pulse_put (unsigned char c)
+{
+  unsigned char next = (tx_head + 1) & (PULSE_TX_SIZE - 1);
+
+  if (next == tx_tail)
+    return 0;
+  tx_buf[tx_head] = c;
+  tx_head = next;
+  _io_ports[M6811_SCCR2] |= M6811_TIE;
+  return 1;
+}
+#endif
+
+#ifdef PULSE_COMMANDS
+/* Send a reply to a serial command.  With -DPULSE_TX_BUFFER this only
+   waits when the buffer is full, without it this waits for the SCI
+   transmitter (about 1 ms per byte at 9600 baud).  */
+static void
+pulse_send (unsigned char c)
+{
+#ifdef PULSE_TX_BUFFER
+  while (!pulse_put (c))
+    continue;
+#else
+  serial_send (c);
+#endif
+}
+#endif
+
+/* Send a status character of the main loop.  With -DPULSE_TX_BUFFER
+   this never waits: the character is dropped when the buffer is
+   full.  */
+static inline void
+pulse_status (unsigned char c)
+{
+#ifdef PULSE_TX_BUFFER
+  pulse_put (c);
+#else
+  serial_send (c);
+#endif
+}
+
+#ifdef PULSE_LOAD
+/* Upload protocol, one frame per pattern:
+
+     'P' <count:2> <entry:2> x count <sum:1>
+
+   Values are big-endian and `sum' is the 8-bit sum of the bytes
+   between 'P' and itself (host/pulseload builds the frame).  The
+   board answers 'K' when the pattern is in the shadow table, 'E' for
+   a bad count or checksum and 'B' when the previous pattern is still
+   waiting for its switch.  A rejected frame is still read to its end,
+   so that its entries are not taken for commands.  After the switch it
+   sends 'S' followed by the number of cycles (modulo 65536) from the
+   end of the upload to the first edge of the new pattern.  */
+enum load_state
+{
+  LOAD_IDLE,
+  LOAD_COUNT_HIGH,
+  LOAD_COUNT_LOW,
+  LOAD_ENTRY_HIGH,
+  LOAD_ENTRY_LOW,
+  LOAD_SUM
+};
+
+static unsigned char load_state;
+static unsigned char load_reject;
+static unsigned char load_sum;
+static unsigned short load_count;
+static unsigned short load_index;
+static unsigned short load_value;
+
+static void
+pulse_load_byte (unsigned char c)
+{
+  unsigned short *shadow = pattern_ram[active_bank ^ 1];
+
+  switch (load_state)
+    {
+    case LOAD_IDLE:
+      load_reject = shadow_ready;
+      if (load_reject)
+        pulse_send ('B');
+      load_sum = 0;
+      load_state = LOAD_COUNT_HIGH;
+      return;
+
+    case LOAD_COUNT_HIGH:
+      load_count = c << 8;
+      load_state = LOAD_COUNT_LOW;
+      break;
+
+    case LOAD_COUNT_LOW:
+      load_count |= c;
+      load_index = 0;
+      load_state = load_count ? LOAD_ENTRY_HIGH : LOAD_SUM;
+      if (!load_reject && (load_count == 0 || load_count > PULSE_LOAD_SIZE))
+        {
+          pulse_send ('E');
+          load_reject = 1;
+        }
+      break;
+
+    case LOAD_ENTRY_HIGH:
+      load_value = c << 8;
+      load_state = LOAD_ENTRY_LOW;
+      break;
+
+    case LOAD_ENTRY_LOW:
+      if (!load_reject)
+        shadow[load_index] = load_value | c;
+      load_index++;
+      load_state = load_index < load_count ? LOAD_ENTRY_HIGH : LOAD_SUM;
+      break;
+
+    case LOAD_SUM:
+      load_state = LOAD_IDLE;
+      if (load_reject)
+        return;
+      if (c != load_sum)
+        {
+          pulse_send ('E');
+          return;
+        }
+      shadow_end = &shadow[load_count];
+      load_done_time = get_timer_counter ();
+      shadow_ready = 1;
+      pulse_send ('K');
+      return;
+    }
+  load_sum += c;
+}
+
+/* Called by the main loop while it waits for the next edge.  */
+static void
+pulse_load_poll (void)
+{
+  unsigned short dt;
+
+  if (load_swapped)
+    {
+      load_swapped = 0;
+      dt = load_first_edge - load_done_time;
+      pulse_send ('S');
+      pulse_send (dt >> 8);
+      pulse_send (dt);
+    }
+}
+#endif
+
+#ifdef PULSE_STREAM
+/* Stream protocol:
+
+     'R'                        stop and empty the stream
+     'D' <count:1> <entry:2> x count
+                                queue `count' intervals
+     'G'                        start playing the queued intervals
+     'F'                        end of the stream
+     'U'                        send the underrun count, 16 bits
+
+   Entries are big-endian.  The board answers 'R' with 'C' <credit:1>,
+   the number of entries the host may send (PULSE_STREAM_SIZE), then
+   sends 'C' <n> each time the handler has taken at least
+   PULSE_STREAM_CREDIT more entries: the host must never have more
+   entries outstanding than its credit, and the FIFO can't overflow
+   whatever the delay of the link.  An entry which does not fit is
+   dropped and answered with 'E'.  The host queues a few blocks before
+   'G' so that the FIFO covers the latency of the link (host/pulsestream
+   sends its whole initial credit).  */
+/* Entries of the current 'D' block still to come, and 1 in
+   `stream_byte' when the next byte is the count of a 'D' block or
+   the low byte of an entry.  */
+static unsigned char stream_count;
+static unsigned char stream_byte;
+static unsigned short stream_value;
+
+static void
+pulse_stream_reset (void)
+{
+  lock ();
+  stream_on = 0;
+  stream_finish = 0;
+  stream_head = stream_tail;
+  stream_granted = stream_tail;
+  stream_underrun = 0;
+  unlock ();
+  pulse_send ('C');
+  pulse_send (PULSE_STREAM_SIZE);
+}
+
+/* Entry byte of a 'D' block.  */
+static void
+pulse_stream_byte (unsigned char c)
+{
+  if (stream_byte == 0)
+    {
+      stream_value = c << 8;
+      stream_byte = 1;
+      return;
+    }
+  stream_byte = 0;
+  stream_count--;
+  if ((unsigned char) (stream_head - stream_tail) >= PULSE_STREAM_SIZE)
+    {
+      pulse_send ('E');
+      return;
+    }
+  stream_buf[stream_head & (PULSE_STREAM_SIZE - 1)] = stream_value | c;
+  stream_head++;
+}
+
+/* Called by the main loop while it waits for the next edge.  */
+static void
+pulse_stream_poll (void)
+{
+  unsigned char n = stream_tail - stream_granted;
+
+  if (n >= PULSE_STREAM_CREDIT)
+    {
+      stream_granted += n;
+      pulse_send ('C');
+      pulse_send (n);
+    }
+}
+#endif
+
+#ifdef PULSE_LATENCY
+static void
+pulse_print_number (unsigned short n)
+{
+  char buf[6];
+  unsigned char i = 0;
+
+  do
+    {
+      buf[i++] = '0' + n % 10;
+      n /= 10;
+    }
+  while (n);
+  while (i)
+    pulse_send (buf[--i]);
+}
+
+/* Send the latency histogram, one `cycles count' line per non-empty
+   bucket (the lower bound of the bucket in E clock cycles), then the
+   largest latency seen.  */
+static void
+pulse_latency_dump (void)
+{
+  unsigned char i;
+
+  for (i = 0; i < PULSE_LATENCY_BUCKETS; i++)
+    {
+      if (latency_hist[i] == 0)
+        continue;
+      pulse_print_number ((i << PULSE_LATENCY_SHIFT) * PULSE_PRESCALER);
+      pulse_send (' ');
+      pulse_print_number (latency_hist[i]);
+      pulse_send ('\r');
+      pulse_send ('\n');
+    }
+  pulse_send ('m');
+  pulse_send (' ');
+  pulse_print_number (latency_max * PULSE_PRESCALER);
+  pulse_send ('\r');
+  pulse_send ('\n');
+}
+
+static void
+pulse_latency_reset (void)
+{
+  unsigned char i;
+
+  lock ();
+  for (i = 0; i < PULSE_LATENCY_BUCKETS; i++)
+    latency_hist[i] = 0;
+  latency_max = 0;
+  unlock ();
+}
+#endif
+
+#ifdef PULSE_COMMANDS
+/* Reply `c' followed by the 16-bit `n', most significant byte first.  */
+static void
+pulse_send_count (unsigned char c, unsigned short n)
+{
+  pulse_send (c);
+  pulse_send (n >> 8);
+  pulse_send (n);
+}
+
+#ifdef PULSE_VERIFY
+static void
+pulse_verify_report (void)
+{
+  pulse_send_count ('V', verify_edges);
+  pulse_send (verify_errors >> 8);
+  pulse_send (verify_errors);
+  pulse_send (verify_max >> 8);
+  pulse_send (verify_max);
+}
+#endif
+
+/* Serial commands:
+
+     'P'   pattern upload (-DPULSE_LOAD, see pulse_load_byte)
+     'L'   dump the latency histogram (-DPULSE_LATENCY)
+     'Z'   clear the latency histogram (-DPULSE_LATENCY)
+     'O'   send the overrun count, 16 bits (-DPULSE_OVERRUN)
+     'M'   send the missed edge count, 16 bits
+     'T'   send the trigger count, the smallest slack and the late
+           trigger count, 16 bits each (-DPULSE_TRIGGER)
+     'V'   send the verified interval count, the error count and the
+           largest error, 16 bits each (-DPULSE_VERIFY)
+     'R', 'D', 'G', 'F', 'U'
+           stream (-DPULSE_STREAM, see pulse_stream_byte)
+
+   Other bytes are ignored.  */
+static void
+pulse_command (unsigned char c)
+{
+#ifdef PULSE_LOAD
+  if (load_state != LOAD_IDLE || c == 'P')
+    {
+      pulse_load_byte (c);
+      return;
+    }
+#endif
+#ifdef PULSE_STREAM
+  if (stream_count)
+    {
+      pulse_stream_byte (c);
+      return;
+    }
+  if (stream_byte)
+    {
+      /* Count byte of a 'D' block.  */
+      stream_count = c;
+      stream_byte = 0;
+      return;
+    }
+  switch (c)
+    {
+    case 'D':
+      stream_byte = 1;
+      break;
+    case 'R':
+      pulse_stream_reset ();
+      break;
+    case 'G':
+      stream_on = 1;
+      break;
+    case 'F':
+      stream_finish = 1;
+      break;
+    case 'U':
+      pulse_send_count ('U', stream_underrun);
+      break;
+    }
+#endif
+#ifdef PULSE_LATENCY
+  if (c == 'L')
+    pulse_latency_dump ();
+  else if (c == 'Z')
+    pulse_latency_reset ();
+#endif
+#ifdef PULSE_OVERRUN
+  if (c == 'O')
+    pulse_send_count ('O', overrun_count);
+#endif
+#ifdef PULSE_TRIGGER
+  if (c == 'T')
+    {
+      pulse_send_count ('T', trigger_count);
+      pulse_send (trigger_slack >> 8);
+      pulse_send (trigger_slack);
+      pulse_send (trigger_late >> 8);
+      pulse_send (trigger_late);
+    }
+#endif
+#ifdef PULSE_VERIFY
+  if (c == 'V')
+    pulse_verify_report ();
+#endif
+  if (c == 'M')
+    pulse_send_count ('M', edge_missed);
+}
+#endif
+
+/* What the main loop does while it waits for the next edge.  */
+static inline void
+pulse_idle (void)
+{
+#ifdef PULSE_COMMANDS
+  if (serial_receive_pending ())
+    pulse_command (serial_recv ());
+#endif
+#ifdef PULSE_LOAD
+  pulse_load_poll ();
+#endif
+#ifdef PULSE_STREAM
+  pulse_stream_poll ();
+#endif
+#ifdef PULSE_VERIFY
+  /* Power-up self test result.  */
+  if (verify_done == 1)
+    {
+      verify_done = 2;
+      pulse_verify_report ();
+    }
+#endif
+}
+
+int
+main ()
+{
+  unsigned short j;
+  unsigned char c = 0;
+  unsigned char i = 0;
+  unsigned char seen;
+  
+  pulse_init ();
+
+  seen = edge_count;
+  for (j = 0; j < 1000; j++)
+    {
+      /* Wait for the output compare interrupt to be raised, unless
+         it already was.
+
+         With -DPULSE_WAI the CPU stops in WAI, which pushes the
+         interrupt frame beforehand: the handler starts without the
+         instruction in flight (1 to 4 cycles in the `sim info' table
+         above) and without the 14 cycles of the frame, and the CPU
+         draws less current in between.  host/pulsesim built with
+         -DPULSE_LATENCY measures 45 cycles from the match to the
+         handler body with the option and 56 to 59 without, that is
+         11 to 14 cycles less per edge.  An edge coming
+         between the test and WAI is only seen at the next one, which
+         the edge counter makes harmless; serial commands are also
+         only polled once per edge.  */
+      if (edge_count == seen)
+        {
+          while (edge_count == seen)
+            {
+              pulse_idle ();
+#ifdef PULSE_WAI
+              wai ();
+#endif
+            }
+        }
+      else
+        edge_missed++;
+      seen++;
+
+      /* Produce some activity on serial line so that we know
+         it is running and interrupts are raised/caught correctly.  */
+      c++;
+      if (c == 1)
+        pulse_status ('\b');
+      else if (c == 128)
+        pulse_status ("-\\|/"[(++i) & 3]);
+    }
+
+#ifdef PULSE_COMMANDS
+  /* Keep accepting commands.  */
+  for (;;)
+    pulse_idle ();
+#endif
   return 0;
 }
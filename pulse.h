@@ -0,0 +1,96 @@
+/* Pulse Generator pattern encoding
+   Copyright (C) 2003 Free Software Foundation, Inc.
+
+This file is free software; you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the
+Free Software Foundation; either version 2, or (at your option) any
+later version.
+
+In addition to the permissions in the GNU General Public License, the
+Free Software Foundation gives you unlimited permission to link the
+compiled version of this file with other programs, and to distribute
+those programs without any restriction coming from the use of this
+file.  (The General Public License restrictions do apply in other
+respects; for example, they cover modification of the file, and
+distribution when not linked into another program.)
+
+This file is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; see the file COPYING.  If not, write to
+the Free Software Foundation, 59 Temple Place - Suite 330,
+Boston, MA 02111-1307, USA.  */
+
+/* Definitions shared by pulse.c and the host tools which produce its
+   patterns.  A pattern table is a list of 16-bit intervals expressed
+   in timer cycles.  Values below PULSE_CODE_LIMIT can never be
+   programmed in time by the interrupt handler, so they are used as
+   codes which change the meaning of the entries that follow.  */
+#ifndef _PULSE_H
+#define _PULSE_H
+
+/* Crystal frequency in Hz (the E clock is a quarter of it) and timer
+   prescaler selected by the PR1/PR0 bits of TMSK2 (1, 4, 8 or 16).
+   Pattern entries are timer counts of 4 * PULSE_PRESCALER /
+   PULSE_CRYSTAL seconds (0.5 us by default).  */
+#ifndef PULSE_CRYSTAL
+# define PULSE_CRYSTAL 8000000
+#endif
+#ifndef PULSE_PRESCALER
+# define PULSE_PRESCALER 1
+#endif
+
+/* Shortest interval, in E clock cycles, that the interrupt handler can
+   program in time.  host/pulsegen rejects patterns which go below.
+   This is an estimate: the Makefile replaces it with the worst case
+   computed by host/isrcycles from the built program (pulse.min).  */
+#ifndef PULSE_MIN_INTERVAL
+# define PULSE_MIN_INTERVAL 100
+#endif
+
+/* Shortest interval, in E clock cycles, within a run of consecutive
+   short intervals: each interrupt can only be taken once the previous
+   one has returned, so a run must leave the time of a whole interrupt
+   per edge (about 136 cycles, see the handler in pulse.c).  Also an
+   estimate; the figure of host/isrcycles covers both.  */
+#ifndef PULSE_RUN_INTERVAL
+# define PULSE_RUN_INTERVAL 136
+#endif
+
+/* With -DPULSE_LOAD the pattern is played from RAM and new patterns
+   are uploaded over the SCI, see pulse_load_byte in pulse.c.  Each of
+   the two RAM tables holds up to PULSE_LOAD_SIZE entries, and
+   host/pulseload refuses longer patterns.  */
+#ifndef PULSE_LOAD_SIZE
+# define PULSE_LOAD_SIZE 64
+#endif
+
+/* PULSE_LONG, high, low: interval of 65536 cycles or more
+   (-DPULSE_EXTENDED).  */
+#define PULSE_LONG       0
+
+/* Run-length encoded patterns (-DPULSE_RLE):
+
+     PULSE_REPEAT, n, value         `value' repeated `n' times
+     PULSE_LOOP, n, ..., PULSE_END_LOOP
+                                    block played `n' times
+
+   Loops nest up to PULSE_RLE_DEPTH deep.  `n' must not be 0.  */
+#define PULSE_REPEAT     1
+#define PULSE_LOOP       2
+#define PULSE_END_LOOP   3
+
+#define PULSE_CODE_LIMIT 4
+
+#ifndef PULSE_RLE_DEPTH
+# define PULSE_RLE_DEPTH 4
+#endif
+
+#define REPEAT(N, V)     PULSE_REPEAT, (N), (V)
+#define LOOP(N)          PULSE_LOOP, (N)
+#define END_LOOP         PULSE_END_LOOP
+
+#endif